@@ -0,0 +1,132 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "canonical.hpp"
+#include "conductivity.hpp"
+#include "graph.hpp"
+
+
+namespace conductivity {
+    // On-disk cache of series keyed by the canonical form of the graph with start and finish coloured,
+    // the physics parameters and the time grid, so isomorphic duplicates and repeated campaigns are
+    // solved once. Every entry is one file named by a 128-bit hash of its key under a two-letter
+    // directory; the file repeats the full key, so a hash collision is a miss, never a wrong result.
+    // The graph is keyed as undirected, so the cache is valid for real waveguides (sin(phase) = 0,
+    // EquitableQuotient::applicable) only: a complex hop depends on edge orientation and vertex labels
+    // and isomorphic relabellings of a cycle are then different physics.
+    // Entries are written to a private temporary file and renamed into place, which is atomic on POSIX,
+    // so ranks sharing the directory see either a complete entry or none without any locking; two ranks
+    // computing the same entry race harmlessly because they store the same series.
+    class ResultCache {
+    private:
+        static constexpr std::uint64_t MAGIC = 0x3230304356434347ull; // "GCVC0002"
+
+        std::filesystem::path root;
+        std::string tag;
+        std::size_t written = 0;
+        graph::Canonizer canonizer;
+        graph::BitGraph bits;
+        std::vector<std::size_t> colours;
+
+        static std::uint64_t mix(std::uint64_t x) {
+            x ^= x >> 30;
+            x *= 0xbf58476d1ce4e5b9ull;
+            x ^= x >> 27;
+            x *= 0x94d049bb133111ebull;
+            x ^= x >> 31;
+            return x;
+        }
+
+        std::filesystem::path path_of(const std::vector<std::uint64_t>& key) const {
+            std::uint64_t h1 = 0x9e3779b97f4a7c15ull, h2 = key.size();
+            for (auto w : key) {
+                h1 = mix(h1 ^ w);
+                h2 = mix(h2 + w + 0x632be59bd9b4e019ull);
+            }
+            char name[40];
+            std::snprintf(name, sizeof(name), "%016llx%016llx", (unsigned long long) h1, (unsigned long long) h2);
+            return root / std::string(name, 2) / name;
+        }
+
+    public:
+        std::size_t hits = 0, misses = 0;
+
+        // tag tells apart the temporary files of concurrent writers, e.g. the MPI rank
+        ResultCache(const std::filesystem::path& root, const std::string& tag) : root(root), tag(tag) {}
+
+        // key of the sink population series for photons started in start and absorbed at finish
+        std::vector<std::uint64_t> key(std::size_t size, const std::vector<graph::Edge>& edges, std::size_t start,
+                                       std::size_t finish, const Parameters& params, std::size_t photons = 1) {
+            bits = graph::BitGraph::from_edges(size, edges);
+            colours.assign(size, 2);
+            colours[start] = 0;
+            colours[finish] = 1;
+            std::vector<std::uint64_t> result = {MAGIC, size, photons, params.points,
+                                                 std::bit_cast<std::uint64_t>(params.coupling),
+                                                 std::bit_cast<std::uint64_t>(params.phase),
+                                                 std::bit_cast<std::uint64_t>(params.leak),
+                                                 std::bit_cast<std::uint64_t>(params.t_max)};
+            auto &certificate = canonizer.canonize(bits, colours);
+            result.insert(result.end(), certificate.begin(), certificate.end());
+            return result;
+        }
+
+        bool load(const std::vector<std::uint64_t>& key, std::vector<double>& series) {
+            std::ifstream in(path_of(key), std::ios::binary);
+            std::uint64_t length = 0, points = 0;
+            if (!in || !in.read(reinterpret_cast<char*>(&length), sizeof(length)) || length != key.size()) {
+                ++misses;
+                return false;
+            }
+            std::vector<std::uint64_t> stored(length);
+            in.read(reinterpret_cast<char*>(stored.data()), length * sizeof(std::uint64_t));
+            in.read(reinterpret_cast<char*>(&points), sizeof(points));
+            if (!in || stored != key) {
+                ++misses;
+                return false;
+            }
+            series.resize(points);
+            if (!in.read(reinterpret_cast<char*>(series.data()), points * sizeof(double))) {
+                ++misses;
+                return false;
+            }
+            ++hits;
+            return true;
+        }
+
+        // best effort: a failed store only costs a recomputation later
+        void store(const std::vector<std::uint64_t>& key, const std::vector<double>& series) {
+            std::filesystem::path target = path_of(key);
+            std::error_code error;
+            std::filesystem::create_directories(target.parent_path(), error);
+
+            std::filesystem::path temporary = target;
+            temporary += ".tmp." + tag + "." + std::to_string(written++);
+            {
+                std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+                std::uint64_t length = key.size(), points = series.size();
+                out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+                out.write(reinterpret_cast<const char*>(key.data()), length * sizeof(std::uint64_t));
+                out.write(reinterpret_cast<const char*>(&points), sizeof(points));
+                out.write(reinterpret_cast<const char*>(series.data()), points * sizeof(double));
+                if (!out) {
+                    out.close();
+                    std::filesystem::remove(temporary, error);
+                    return;
+                }
+            }
+            std::filesystem::rename(temporary, target, error);
+            if (error) {
+                std::filesystem::remove(temporary, error);
+            }
+        }
+    };
+}
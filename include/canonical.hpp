@@ -0,0 +1,367 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "graph.hpp"
+
+
+namespace graph {
+    // graph with runtime size stored as rows of adjacency bits
+    class BitGraph {
+    private:
+        std::size_t n;
+        std::size_t words;
+        std::vector<std::uint64_t> bits;
+
+    public:
+        BitGraph(std::size_t n = 0) {
+            this->resize(n);
+        }
+
+        void resize(std::size_t new_n) {
+            n = new_n;
+            words = (n + 63) / 64;
+            bits.assign(n * words, 0);
+        }
+
+        void clear() {
+            std::fill(bits.begin(), bits.end(), 0);
+        }
+
+        std::size_t size() const {
+            return n;
+        }
+
+        std::size_t row_words() const {
+            return words;
+        }
+
+        const std::uint64_t* row(std::size_t v) const {
+            return bits.data() + v * words;
+        }
+
+        bool operator()(std::size_t x, std::size_t y) const {
+            return (bits[x * words + y / 64] >> (y % 64)) & 1;
+        }
+
+        void add_edge(std::size_t x, std::size_t y) {
+            bits[x * words + y / 64] |= std::uint64_t(1) << (y % 64);
+            bits[y * words + x / 64] |= std::uint64_t(1) << (x % 64);
+        }
+
+        void remove_edge(std::size_t x, std::size_t y) {
+            bits[x * words + y / 64] &= ~(std::uint64_t(1) << (y % 64));
+            bits[y * words + x / 64] &= ~(std::uint64_t(1) << (x % 64));
+        }
+
+        std::size_t degree(std::size_t v) const {
+            std::size_t d = 0;
+            for (std::size_t w = 0; w < words; ++w) {
+                d += std::popcount(bits[v * words + w]);
+            }
+            return d;
+        }
+
+        static BitGraph from_edges(std::size_t n, const std::vector<Edge>& edges) {
+            BitGraph g(n);
+            for (auto &e : edges) {
+                g.add_edge(e[0], e[1]);
+            }
+            return g;
+        }
+
+        template<std::size_t size>
+        static BitGraph from_graph(const Graph<size>& graph) {
+            BitGraph g(size);
+            for (std::size_t i = 0; i < size; ++i) {
+                for (auto j : graph.neighbours(i)) {
+                    if (i < j) {
+                        g.add_edge(i, j);
+                    }
+                }
+            }
+            return g;
+        }
+    };
+
+    // Canonical labeling by individualization-refinement (McKay, "Practical graph isomorphism").
+    // The certificate is the upper triangle of the adjacency matrix under the lexicographically largest
+    // labeling among the leaves of the search tree, followed by the sizes of the initial colour classes,
+    // so two coloured graphs are isomorphic iff their certificates are equal. Subtrees are pruned with
+    // automorphisms found on the way (orbits of the pointwise stabilizer of the current path and the jump
+    // back to the first path), which keeps highly symmetric graphs (K_n, cycles, hypercubes) polynomial.
+    class Canonizer {
+    private:
+        static constexpr std::size_t NO_JUMP = ~std::size_t(0);
+
+        const BitGraph *g;
+        std::size_t n;
+
+        // ordered partition of every search level: vertices by position and cell start positions
+        std::vector<std::vector<std::size_t>> lab_at;
+        std::vector<std::vector<std::size_t>> starts_at;
+        std::vector<std::vector<std::size_t>> cell_at, explored_at;
+        std::vector<std::size_t> path, first_path;
+
+        bool have_first;
+        std::vector<std::uint64_t> cert, first_cert, best_cert, colour_sizes;
+        std::vector<std::size_t> first_lab, best_lab;
+        std::vector<std::vector<std::size_t>> autos;
+
+        std::vector<std::uint64_t> mask;
+        std::vector<std::pair<std::size_t, std::size_t>> keyed;
+        std::vector<std::size_t> new_starts, splitters;
+        std::vector<bool> queued;
+        std::vector<std::size_t> uf;
+
+        std::size_t cell_end(const std::vector<std::size_t>& starts, std::size_t k) const {
+            return k + 1 < starts.size() ? starts[k + 1] : n;
+        }
+
+        // splits cells by the number of neighbours in splitter cells until the partition is equitable,
+        // every fragment of a split cell becomes a splitter again
+        void refine(std::vector<std::size_t>& lab, std::vector<std::size_t>& starts) {
+            std::size_t words = g->row_words();
+            queued.assign(n, false);
+            splitters.clear();
+            for (auto &st : starts) {
+                splitters.push_back(st);
+                queued[st] = true;
+            }
+
+            for (std::size_t q = 0; q < splitters.size() && starts.size() < n; ++q) {
+                std::size_t ws = splitters[q];
+                queued[ws] = false;
+                std::size_t k = std::lower_bound(starts.begin(), starts.end(), ws) - starts.begin();
+                std::fill(mask.begin(), mask.end(), 0);
+                for (std::size_t p = ws; p < cell_end(starts, k); ++p) {
+                    mask[lab[p] / 64] |= std::uint64_t(1) << (lab[p] % 64);
+                }
+
+                for (std::size_t j = 0; j < starts.size(); ++j) {
+                    std::size_t js = starts[j], je = cell_end(starts, j);
+                    if (je - js < 2) {
+                        continue;
+                    }
+                    keyed.clear();
+                    bool uniform = true;
+                    for (std::size_t p = js; p < je; ++p) {
+                        const std::uint64_t *r = g->row(lab[p]);
+                        std::size_t c = 0;
+                        for (std::size_t w = 0; w < words; ++w) {
+                            c += std::popcount(r[w] & mask[w]);
+                        }
+                        uniform = uniform && (keyed.empty() || keyed.back().first == c);
+                        keyed.emplace_back(c, lab[p]);
+                    }
+                    if (uniform) {
+                        continue;
+                    }
+
+                    std::sort(keyed.begin(), keyed.end());
+                    new_starts.clear();
+                    for (std::size_t p = js; p < je; ++p) {
+                        lab[p] = keyed[p - js].second;
+                        if (p != js && keyed[p - js].first != keyed[p - js - 1].first) {
+                            new_starts.push_back(p);
+                        }
+                    }
+                    starts.insert(starts.begin() + j + 1, new_starts.begin(), new_starts.end());
+                    if (!queued[js]) {
+                        queued[js] = true;
+                        splitters.push_back(js);
+                    }
+                    for (auto &st : new_starts) {
+                        queued[st] = true;
+                        splitters.push_back(st);
+                    }
+                    j += new_starts.size();
+                }
+            }
+        }
+
+        void leaf_certificate(const std::vector<std::size_t>& lab, std::vector<std::uint64_t>& out) const {
+            out.assign((n * (n - 1) / 2 + 63) / 64, 0);
+            std::size_t bit = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                for (std::size_t j = i + 1; j < n; ++j, ++bit) {
+                    if ((*g)(lab[i], lab[j])) {
+                        out[bit / 64] |= std::uint64_t(1) << (63 - bit % 64);
+                    }
+                }
+            }
+            out.insert(out.end(), colour_sizes.begin(), colour_sizes.end());
+        }
+
+        void add_automorphism(const std::vector<std::size_t>& from, const std::vector<std::size_t>& to) {
+            std::vector<std::size_t> perm(n);
+            for (std::size_t i = 0; i < n; ++i) {
+                perm[from[i]] = to[i];
+            }
+            autos.push_back(perm);
+        }
+
+        std::size_t find(std::size_t v) {
+            while (uf[v] != v) {
+                uf[v] = uf[uf[v]];
+                v = uf[v];
+            }
+            return v;
+        }
+
+        // orbits of the group generated by the found automorphisms which fix the current path
+        void stabilizer_orbits(std::size_t level) {
+            for (std::size_t v = 0; v < n; ++v) {
+                uf[v] = v;
+            }
+            for (auto &perm : autos) {
+                bool fixes = true;
+                for (std::size_t l = 0; l < level && fixes; ++l) {
+                    fixes = perm[path[l]] == path[l];
+                }
+                if (!fixes) {
+                    continue;
+                }
+                for (std::size_t v = 0; v < n; ++v) {
+                    std::size_t a = find(v), b = find(perm[v]);
+                    if (a != b) {
+                        uf[std::max(a, b)] = std::min(a, b);
+                    }
+                }
+            }
+        }
+
+        std::size_t search(std::size_t level) {
+            const std::vector<std::size_t>& lab = lab_at[level];
+            const std::vector<std::size_t>& starts = starts_at[level];
+
+            if (starts.size() == n) {
+                leaf_certificate(lab, cert);
+                if (!have_first) {
+                    have_first = true;
+                    first_cert = best_cert = cert;
+                    first_lab = best_lab = lab;
+                    first_path = path;
+                    return NO_JUMP;
+                }
+                if (cert == first_cert) {
+                    // the subtree below the last common node of this and the first path is equivalent to the first one
+                    add_automorphism(first_lab, lab);
+                    std::size_t common = 0;
+                    while (common < path.size() && path[common] == first_path[common]) {
+                        ++common;
+                    }
+                    return common;
+                }
+                if (best_cert < cert) {
+                    best_cert = cert;
+                    best_lab = lab;
+                } else if (cert == best_cert) {
+                    add_automorphism(best_lab, lab);
+                }
+                return NO_JUMP;
+            }
+
+            std::size_t target = 0;
+            while (cell_end(starts, target) - starts[target] < 2) {
+                ++target;
+            }
+            std::size_t ts = starts[target];
+            std::vector<std::size_t>& cell = cell_at[level];
+            std::vector<std::size_t>& explored = explored_at[level];
+            cell.assign(lab.begin() + ts, lab.begin() + cell_end(starts, target));
+            explored.clear();
+
+            for (auto &x : cell) {
+                if (!explored.empty()) {
+                    stabilizer_orbits(level);
+                    bool pruned = false;
+                    for (auto &y : explored) {
+                        pruned = pruned || find(x) == find(y);
+                    }
+                    if (pruned) {
+                        continue;
+                    }
+                }
+                explored.push_back(x);
+
+                std::vector<std::size_t>& child_lab = lab_at[level + 1];
+                std::vector<std::size_t>& child_starts = starts_at[level + 1];
+                child_lab = lab;
+                child_starts = starts;
+                std::swap(child_lab[ts], *std::find(child_lab.begin() + ts, child_lab.end(), x));
+                child_starts.insert(child_starts.begin() + target + 1, ts + 1);
+                refine(child_lab, child_starts);
+
+                path.push_back(x);
+                std::size_t jump = search(level + 1);
+                path.pop_back();
+                if (jump < level) {
+                    return jump;
+                }
+            }
+            return NO_JUMP;
+        }
+
+    public:
+        // certificate of graph, colours (if given) form the ordered initial partition
+        const std::vector<std::uint64_t>& canonize(const BitGraph& graph, const std::vector<std::size_t>& colours) {
+            g = &graph;
+            n = graph.size();
+            mask.assign(graph.row_words(), 0);
+            uf.resize(n);
+            lab_at.resize(n + 1);
+            starts_at.resize(n + 1);
+            cell_at.resize(n + 1);
+            explored_at.resize(n + 1);
+            path.clear();
+            autos.clear();
+            have_first = false;
+
+            std::vector<std::size_t>& lab = lab_at[0];
+            std::vector<std::size_t>& starts = starts_at[0];
+            lab.resize(n);
+            starts.clear();
+            colour_sizes.clear();
+            for (std::size_t v = 0; v < n; ++v) {
+                lab[v] = v;
+            }
+            if (!colours.empty()) {
+                std::sort(lab.begin(), lab.end(), [&](std::size_t a, std::size_t b) {
+                    return colours[a] < colours[b] || (colours[a] == colours[b] && a < b);
+                });
+            }
+            for (std::size_t p = 0; p < n; ++p) {
+                if (p == 0 || (!colours.empty() && colours[lab[p]] != colours[lab[p - 1]])) {
+                    if (p != 0) {
+                        colour_sizes.push_back(p - starts.back());
+                    }
+                    starts.push_back(p);
+                }
+            }
+            colour_sizes.push_back(n - (starts.empty() ? 0 : starts.back()));
+
+            if (n == 0) {
+                best_cert = colour_sizes;
+                best_lab.clear();
+                return best_cert;
+            }
+            refine(lab, starts);
+            search(0);
+            return best_cert;
+        }
+
+        const std::vector<std::uint64_t>& canonize(const BitGraph& graph) {
+            return canonize(graph, {});
+        }
+
+        // canonical labeling of the last canonized graph: vertex at canonical position i
+        const std::vector<std::size_t>& labeling() const {
+            return best_lab;
+        }
+    };
+}
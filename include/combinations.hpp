@@ -0,0 +1,155 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace graph {
+    // The k-subsets of n < 64 positions as bit masks in decreasing numeric order, the order
+    // std::prev_permutation walks an indicator vector whose first element is the highest bit. Ranks
+    // come from the combinatorial number system, so any stretch of the sequence can be started
+    // without walking the ones before it.
+    class Combinations {
+    private:
+        std::size_t n, k;
+        std::vector<std::vector<std::uint64_t>> binom;
+
+    public:
+        Combinations(std::size_t n, std::size_t k) : n(n), k(k) {
+            if (63 < n || n < k) {
+                throw "Error - combinations: incorrect subset size";
+            }
+            binom.assign(n + 1, std::vector<std::uint64_t>(k + 2, 0));
+            for (std::size_t a = 0; a <= n; ++a) {
+                binom[a][0] = 1;
+                for (std::size_t b = 1; b <= k + 1 && b <= a; ++b) {
+                    binom[a][b] = binom[a - 1][b - 1] + binom[a - 1][b];
+                }
+            }
+        }
+
+        std::uint64_t count() const {
+            return binom[n][k];
+        }
+
+        std::uint64_t rank(std::uint64_t mask) const {
+            std::uint64_t increasing = 0;
+            for (std::size_t i = 0; mask; mask &= mask - 1, ++i) {
+                increasing += binom[std::countr_zero(mask)][i + 1];
+            }
+            return this->count() - 1 - increasing;
+        }
+
+        std::uint64_t unrank(std::uint64_t r) const {
+            std::uint64_t increasing = this->count() - 1 - r, mask = 0;
+            std::size_t p = n;
+            for (std::size_t i = k; i-- > 0;) {
+                do {
+                    --p;
+                } while (increasing < binom[p][i + 1]);
+                increasing -= binom[p][i + 1];
+                mask |= std::uint64_t(1) << p;
+            }
+            return mask;
+        }
+
+        // the mask of the next rank, Gosper's hack on the complement; undefined for the last one
+        std::uint64_t previous(std::uint64_t mask) const {
+            std::uint64_t all = (std::uint64_t(1) << n) - 1;
+            std::uint64_t y = all & ~mask;
+            std::uint64_t lowest = y & -y;
+            std::uint64_t ripple = y + lowest;
+            return all & ~((((ripple ^ y) >> 2) / lowest) | ripple);
+        }
+    };
+
+    // The k-subsets of n < 64 positions in revolving door order (Nijenhuis and Wilf): the list for n is the
+    // list for n - 1 followed by the reversed list of (k - 1)-subsets of n - 1 positions, each with position
+    // n - 1 added. Consecutive subsets differ in exactly one position in and one out. The subsets with
+    // largest position m are the ranks [C(m, k), C(m + 1, k)), which gives rank and unrank in O(n + k).
+    class RevolvingDoor {
+    private:
+        std::size_t n, k;
+        std::vector<std::vector<std::uint64_t>> binom;
+
+    public:
+        RevolvingDoor(std::size_t n, std::size_t k) : n(n), k(k) {
+            if (63 < n || n < k || k == 0) {
+                throw "Error - combinations: incorrect subset size";
+            }
+            binom.assign(n + 2, std::vector<std::uint64_t>(k + 1, 0));
+            for (std::size_t a = 0; a <= n + 1; ++a) {
+                binom[a][0] = 1;
+                for (std::size_t b = 1; b <= k && b <= a; ++b) {
+                    binom[a][b] = binom[a - 1][b - 1] + binom[a - 1][b];
+                }
+            }
+        }
+
+        std::uint64_t count() const {
+            return binom[n][k];
+        }
+
+        // sum of (-1)^(k - i) (C(p_i + 1, i) - 1) over the positions p_1 < .. < p_k
+        std::uint64_t rank(std::uint64_t mask) const {
+            std::uint64_t r = 0;
+            for (std::size_t i = 1; mask; mask &= mask - 1, ++i) {
+                r = binom[std::countr_zero(mask) + 1][i] - 1 - r;
+            }
+            return r;
+        }
+
+        std::uint64_t unrank(std::uint64_t r) const {
+            std::uint64_t mask = 0;
+            std::size_t p = n;
+            for (std::size_t i = k; 0 < i; --i) {
+                do {
+                    --p;
+                } while (r < binom[p][i]);
+                mask |= std::uint64_t(1) << p;
+                r = binom[p + 1][i] - 1 - r;
+            }
+            return mask;
+        }
+
+        // the mask of the next rank, one position out and one in, by Knuth's Algorithm 7.2.1.3R on the
+        // positions c_1 < .. < c_k (c_(k + 1) = n): the lowest positions that can move do, amortized O(1);
+        // undefined for the last one
+        std::uint64_t next(std::uint64_t mask) const {
+            std::uint64_t rest = mask;
+            auto bit = [](std::size_t p) {
+                return std::uint64_t(1) << p;
+            };
+            auto peek = [&]() -> std::size_t {
+                return rest ? std::countr_zero(rest) : n;
+            };
+            auto pop = [&]() {
+                std::size_t p = peek();
+                rest &= rest - 1;
+                return p;
+            };
+
+            // c_1 moves up for odd k and down for even k, the direction alternates with j
+            std::size_t c = pop();
+            bool up = k % 2 == 1;
+            if (up ? c + 1 < peek() : 0 < c) {
+                return mask ^ bit(c) ^ bit(up ? c + 1 : c - 1);
+            }
+            for (std::size_t j = 2; j <= k; ++j) {
+                up = !up;
+                c = pop();
+                if (!up && j <= c) {
+                    // c_(j - 1) = c_j - 1, the pair moves down to j - 2, c_j - 1
+                    return mask ^ bit(c) ^ bit(j - 2);
+                }
+                if (up && c + 1 < peek()) {
+                    // c_(j - 1) = j - 2, the pair moves up to c_j, c_j + 1
+                    return mask ^ bit(j - 2) ^ bit(c + 1);
+                }
+            }
+            return mask;
+        }
+    };
+}
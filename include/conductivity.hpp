@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "graph.hpp"
+#include "krylov.hpp"
+#include "linalg.hpp"
+#include "sparse.hpp"
+
+
+namespace conductivity {
+    using linalg::complex;
+    using linalg::cvector;
+
+    // physics of the single photon transfer, defaults are the values of states_calculating
+    struct Parameters {
+        double coupling = 0.09;     // waveguide amplitude between adjacent cavities
+        double phase = 2 * M_PI;    // waveguide phase
+        double leak = 0.012;        // decay rate of the finish cavity into the sink, set_leak_for_cavity of states_calculating
+        double t_max = 500;         // the old series driver; its sigma driver took the final value at 1000
+        std::size_t points = 2000;  // time grid linspace(0, t_max, points)
+    };
+
+    inline std::vector<double> time_grid(const Parameters& params) {
+        std::vector<double> t(params.points);
+        for (std::size_t i = 0; i < params.points; ++i) {
+            t[i] = params.points == 1 ? params.t_max : params.t_max * double(i) / double(params.points - 1);
+        }
+        return t;
+    }
+
+    // Effective Hamiltonian of the one-photon sector, O(n + m) memory. The photon lost to the sink
+    // leaves the sector, so the no-jump evolution with H - i leak / 2 |finish><finish| reproduces
+    // the master equation exactly and the sink population is 1 - |psi|^2.
+    inline linalg::CsrMatrix hamiltonian(std::size_t size, const std::vector<graph::Edge>& edges,
+                                         std::size_t finish, const Parameters& params) {
+        std::vector<std::pair<std::pair<std::size_t, std::size_t>, complex>> entries;
+        entries.reserve(2 * edges.size() + 1);
+        complex hop = std::polar(params.coupling, params.phase);
+        for (auto &e : edges) {
+            std::size_t i = std::min(e[0], e[1]), j = std::max(e[0], e[1]);
+            if (i == j) {
+                continue;
+            }
+            entries.push_back({{i, j}, hop});
+            entries.push_back({{j, i}, std::conj(hop)});
+        }
+        entries.push_back({{finish, finish}, complex(0, -params.leak / 2)});
+        return linalg::CsrMatrix(size, entries);
+    }
+
+    // Observables of a photon started in cavity start (a basis index of h): observer(step, sink, populations)
+    // is called for every grid point with the sink population and the populations of the given vertices,
+    // in their order. Only the Krylov state is kept, so memory does not grow with the number of points.
+    template<class Operator, class Observer>
+    void observe(const Operator& h, std::size_t start, const Parameters& params, const std::vector<std::size_t>& vertices,
+                 linalg::KrylovPropagator& propagator, Observer&& observer) {
+        std::vector<double> populations(vertices.size());
+        if (params.points == 0) {
+            return;
+        }
+        cvector psi(h.dim(), 0);
+        psi[start] = 1;
+
+        auto t = time_grid(params);
+        if (params.points < 2) {
+            if (0 < t[0]) {
+                propagator.propagate(h, psi, t[0]);
+            }
+            for (std::size_t i = 0; i < vertices.size(); ++i) {
+                populations[i] = std::norm(psi[vertices[i]]);
+            }
+            double survived = linalg::norm(psi);
+            observer(std::size_t(0), 0 < t[0] ? 1 - survived * survived : 0.0, populations.data());
+            return;
+        }
+        for (std::size_t i = 0; i < vertices.size(); ++i) {
+            populations[i] = vertices[i] == start ? 1 : 0;
+        }
+        observer(std::size_t(0), 0.0, populations.data());
+        propagator.propagate_grid(h, psi, t[1] - t[0], params.points - 1, [&](std::size_t step) {
+            for (std::size_t i = 0; i < vertices.size(); ++i) {
+                populations[i] = std::norm(propagator.component(vertices[i]));
+            }
+            observer(step, 1 - propagator.norm2(), populations.data());
+        });
+    }
+
+    // observables into a preallocated buffer of (1 + vertices.size()) * points doubles: the sink series
+    // followed by the series of every vertex
+    template<class Operator>
+    void observe_into(const Operator& h, std::size_t start, const Parameters& params, const std::vector<std::size_t>& vertices,
+                      linalg::KrylovPropagator& propagator, double* buffer) {
+        std::size_t points = params.points;
+        observe(h, start, params, vertices, propagator, [&](std::size_t step, double sink, const double* populations) {
+            buffer[step] = sink;
+            for (std::size_t i = 0; i < vertices.size(); ++i) {
+                buffer[(i + 1) * points + step] = populations[i];
+            }
+        });
+    }
+
+    // sink population on the time grid for a photon started in cavity start
+    template<class Operator>
+    std::vector<double> sink_population(const Operator& h, std::size_t start, const Parameters& params,
+                                        linalg::KrylovPropagator& propagator) {
+        std::vector<double> result(params.points);
+        observe_into(h, start, params, {}, propagator, result.data());
+        return result;
+    }
+
+    inline std::vector<double> sink_population(std::size_t size, const std::vector<graph::Edge>& edges,
+                                               std::size_t start, std::size_t finish, const Parameters& params) {
+        linalg::KrylovPropagator propagator;
+        return sink_population(hamiltonian(size, edges, finish, params), start, params, propagator);
+    }
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "small_graph.hpp"
+
+
+namespace graph {
+    // Isomorphism invariants of a small graph packed in three words, equal for isomorphic graphs:
+    // the sorted degree sequence with the number of leaves, the sorted eccentricities (15 for vertices
+    // not reached from every other one) and a hash of the multiset of (degree, sorted neighbour degrees)
+    // over the vertices. Different fingerprints prove two graphs non-isomorphic, equal ones say nothing.
+    struct Fingerprint {
+        std::uint64_t degrees = 0;
+        std::uint64_t eccentricities = 0;
+        std::uint64_t neighbourhoods = 0;
+
+        bool operator==(const Fingerprint& other) const {
+            return degrees == other.degrees && eccentricities == other.eccentricities &&
+                   neighbourhoods == other.neighbourhoods;
+        }
+
+        bool operator!=(const Fingerprint& other) const {
+            return !(*this == other);
+        }
+    };
+
+    namespace detail {
+        // values below 16, sorted and packed four bits each
+        template<std::size_t size>
+        std::uint64_t pack_sorted(std::array<std::uint8_t, size> values) {
+            std::sort(values.begin(), values.end());
+            std::uint64_t result = 0;
+            for (std::size_t i = 0; i < size; ++i) {
+                result |= std::uint64_t(values[i]) << (4 * i);
+            }
+            return result;
+        }
+
+        inline std::uint64_t mix(std::uint64_t x) {
+            x ^= x >> 30;
+            x *= 0xbf58476d1ce4e5b9ull;
+            x ^= x >> 27;
+            x *= 0x94d049bb133111ebull;
+            x ^= x >> 31;
+            return x;
+        }
+    }
+
+    // all invariants in O(size * diameter) word operations, the breadth-first searches run on
+    // neighbourhood masks
+    template<std::size_t size>
+    Fingerprint fingerprint(const SmallGraph<size>& graph) {
+        std::array<typename SmallGraph<size>::row_mask, size> rows;
+        std::array<std::uint8_t, size> degrees, eccentricities;
+        std::size_t leaves = 0;
+        for (std::size_t v = 0; v < size; ++v) {
+            rows[v] = graph.row(v);
+            degrees[v] = std::uint8_t(std::popcount(rows[v]));
+            leaves += degrees[v] == 1;
+        }
+
+        const typename SmallGraph<size>::row_mask all = (1u << size) - 1;
+        for (std::size_t v = 0; v < size; ++v) {
+            typename SmallGraph<size>::row_mask reached = 1u << v, frontier = reached;
+            std::uint8_t level = 0;
+            while (true) {
+                typename SmallGraph<size>::row_mask next = 0;
+                for (auto rest = frontier; rest; rest &= rest - 1) {
+                    next |= rows[std::countr_zero(rest)];
+                }
+                frontier = next & ~reached;
+                if (!frontier) {
+                    break;
+                }
+                reached |= frontier;
+                ++level;
+            }
+            eccentricities[v] = reached == all ? level : 15;
+        }
+
+        std::array<std::uint64_t, size> signatures;
+        for (std::size_t v = 0; v < size; ++v) {
+            std::array<std::uint8_t, size> around{};
+            std::size_t k = 0;
+            for (auto rest = rows[v]; rest; rest &= rest - 1) {
+                around[k++] = degrees[std::countr_zero(rest)];
+            }
+            signatures[v] = detail::pack_sorted(around) ^ (std::uint64_t(degrees[v]) << 60);
+        }
+        std::sort(signatures.begin(), signatures.end());
+
+        Fingerprint result;
+        result.degrees = detail::pack_sorted(degrees) | (std::uint64_t(leaves) << 56);
+        result.eccentricities = detail::pack_sorted(eccentricities);
+        result.neighbourhoods = size;
+        for (auto s : signatures) {
+            result.neighbourhoods = detail::mix(result.neighbourhoods ^ s);
+        }
+        return result;
+    }
+
+    // Fingerprints of a growing list of graphs stored as one array per word, so the scan for the
+    // entries equal to a query is a branch-free loop over contiguous words that the compiler
+    // vectorizes; a whole block is compared before any candidate is visited.
+    class FingerprintTable {
+    private:
+        static constexpr std::size_t BLOCK = 64;
+
+        std::vector<std::uint64_t> degrees;
+        std::vector<std::uint64_t> eccentricities;
+        std::vector<std::uint64_t> neighbourhoods;
+
+    public:
+        std::size_t size() const {
+            return degrees.size();
+        }
+
+        void push_back(const Fingerprint& fp) {
+            degrees.push_back(fp.degrees);
+            eccentricities.push_back(fp.eccentricities);
+            neighbourhoods.push_back(fp.neighbourhoods);
+        }
+
+        Fingerprint operator[](std::size_t i) const {
+            return {degrees[i], eccentricities[i], neighbourhoods[i]};
+        }
+
+        // calls visit(i) for every entry equal to fp in increasing order until it returns true,
+        // true if some call did
+        template<typename Visit>
+        bool find_if(const Fingerprint& fp, Visit&& visit) const {
+            std::size_t n = degrees.size();
+            const std::uint64_t *d = degrees.data(), *e = eccentricities.data(), *h = neighbourhoods.data();
+            std::array<std::uint8_t, BLOCK> equal;
+            for (std::size_t begin = 0; begin < n; begin += BLOCK) {
+                std::size_t count = std::min(BLOCK, n - begin);
+                for (std::size_t i = 0; i < count; ++i) {
+                    equal[i] = (d[begin + i] == fp.degrees) & (e[begin + i] == fp.eccentricities) &
+                               (h[begin + i] == fp.neighbourhoods);
+                }
+                for (std::size_t i = 0; i < count; ++i) {
+                    if (equal[i] && visit(begin + i)) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+    };
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "conductivity.hpp"
+#include "krylov.hpp"
+#include "linalg.hpp"
+#include "sparse.hpp"
+
+
+namespace conductivity {
+    using linalg::complex;
+    using linalg::cvector;
+
+    // Basis of the sector with k photons in n cavities. A state is the sorted list of occupied cavities
+    // c_0 <= ... <= c_(k-1) (a cavity repeats as many times as it holds photons); d_i = c_i + i is then
+    // a k-combination of n + k - 1 (stars and bars) and its rank in the combinatorial number system,
+    // sum C(d_i, i + 1), is the basis index. Ranks follow colex order, so the whole basis is walked by
+    // next() and no state list is ever stored.
+    class FockBasis {
+    private:
+        std::size_t n, k;
+        std::vector<std::vector<std::uint64_t>> binom;
+
+    public:
+        FockBasis(std::size_t n, std::size_t k) : n(n), k(k) {
+            if (n == 0 || k == 0) {
+                throw "Error - fock basis: empty sector";
+            }
+            binom.assign(n + k, std::vector<std::uint64_t>(k + 1, 0));
+            for (std::size_t a = 0; a < n + k; ++a) {
+                binom[a][0] = 1;
+                for (std::size_t b = 1; b <= std::min(a, k); ++b) {
+                    binom[a][b] = binom[a - 1][b - 1] + binom[a - 1][b];
+                }
+            }
+        }
+
+        std::size_t cavities() const {
+            return n;
+        }
+
+        std::size_t photons() const {
+            return k;
+        }
+
+        std::uint64_t dim() const {
+            return binom[n + k - 1][k];
+        }
+
+        // cavities should be sorted
+        std::uint64_t rank(const std::size_t* cavities) const {
+            std::uint64_t r = 0;
+            for (std::size_t i = 0; i < k; ++i) {
+                r += binom[cavities[i] + i][i + 1];
+            }
+            return r;
+        }
+
+        void unrank(std::uint64_t r, std::size_t* cavities) const {
+            std::size_t d = n + k - 1;
+            for (std::size_t i = k; i-- > 0;) {
+                do {
+                    --d;
+                } while (r < binom[d][i + 1]);
+                r -= binom[d][i + 1];
+                cavities[i] = d - i;
+            }
+        }
+
+        // sorted cavities of the state with the next rank
+        void next(std::size_t* cavities) const {
+            for (std::size_t i = 0; i < k; ++i) {
+                if (i + 1 == k || cavities[i] < cavities[i + 1]) {
+                    ++cavities[i];
+                    for (std::size_t j = 0; j < i; ++j) {
+                        cavities[j] = 0;
+                    }
+                    return;
+                }
+            }
+        }
+    };
+
+    // Matrix-free second quantization sum_ij h_ij a_i^+ a_j of a one-body operator in the k-photon sector.
+    // The off-diagonal part of h should be Hermitian (waveguides), the diagonal may be complex (leaks,
+    // giving -i leak / 2 n_finish). Memory is the binomial table only; one apply costs O(dim * k * degree).
+    class FockHamiltonian {
+    private:
+        const linalg::CsrMatrix& one_body;
+        FockBasis basis;
+
+    public:
+        FockHamiltonian(const linalg::CsrMatrix& one_body, std::size_t photons)
+            : one_body(one_body), basis(one_body.dim(), photons) {}
+
+        const FockBasis& fock_basis() const {
+            return basis;
+        }
+
+        std::size_t dim() const {
+            return basis.dim();
+        }
+
+        void apply(const cvector& in, cvector& out) const {
+            std::size_t k = basis.photons();
+            std::size_t d = basis.dim();
+            out.assign(d, 0);
+            std::vector<std::size_t> c(k, 0), moved(k);
+
+            for (std::uint64_t r = 0; r < d; basis.next(c.data()), ++r) {
+                complex x = in[r];
+                if (x == complex(0)) {
+                    continue;
+                }
+                for (std::size_t a = 0; a < k; ++a) {
+                    if (a != 0 && c[a] == c[a - 1]) {
+                        continue;
+                    }
+                    std::size_t j = c[a];
+                    std::size_t n_j = std::upper_bound(c.begin(), c.end(), j) - (c.begin() + a);
+
+                    for (std::size_t idx = one_body.row_begin(j); idx < one_body.row_end(j); ++idx) {
+                        std::size_t i = one_body.column(idx);
+                        if (i == j) {
+                            out[r] += one_body.value(idx) * double(n_j) * x;
+                            continue;
+                        }
+                        // photon hops j -> i with h_ij = conj(h_ji)
+                        std::size_t n_i = std::upper_bound(c.begin(), c.end(), i) - std::lower_bound(c.begin(), c.end(), i);
+                        complex amp = std::conj(one_body.value(idx)) * std::sqrt(double(n_j * (n_i + 1)));
+
+                        moved = c;
+                        moved[a] = i;
+                        std::sort(moved.begin(), moved.end());
+                        out[basis.rank(moved.data())] += amp * x;
+                    }
+                }
+            }
+        }
+    };
+
+    // bytes needed to evolve the k-photon sector with a Krylov basis of krylov_dim vectors
+    // (basis, state and two work vectors)
+    inline double fock_memory_bytes(std::size_t size, std::size_t photons, std::size_t krylov_dim) {
+        FockBasis basis(size, photons);
+        return double(basis.dim()) * sizeof(complex) * double(krylov_dim + 4);
+    }
+
+    // Probability that the sink has absorbed at least one of the photons, photon i started in cavity starts[i].
+    // The sector of k photons loses norm whenever any photon leaks, so this is 1 - |psi_k|^2. Photons started
+    // in different cavities interfere: the survival is the permanent of the Gram matrix of their one-photon
+    // states, not the product of their survivals.
+    inline std::vector<double> sink_population(const linalg::CsrMatrix& one_body, const std::vector<std::size_t>& starts,
+                                               const Parameters& params, linalg::KrylovPropagator& propagator) {
+        FockHamiltonian h(one_body, starts.size());
+        std::vector<std::size_t> cavities = starts;
+        std::sort(cavities.begin(), cavities.end());
+        std::size_t initial = h.fock_basis().rank(cavities.data());
+
+        return sink_population(h, initial, params, propagator);
+    }
+
+    // k photons started in one cavity are k independent copies of the one-photon walk, the sector solve
+    // reduces to 1 - (1 - p)^k of the one-photon sink population p, in place
+    inline void independent_photons(std::vector<double>& series, std::size_t photons) {
+        for (auto &p : series) {
+            p = 1 - std::pow(1 - p, double(photons));
+        }
+    }
+}
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "graph.hpp"
+
+
+namespace graph {
+    // G(n, p) by geometric skipping over the lower triangle (Batagelj, Brandes, 2005):
+    // the gap to the next edge is drawn directly, so the cost is O(n + m) instead of O(n^2)
+    template<class Rng>
+    void random_gnp(std::size_t size, double p, Rng& rng, std::vector<Edge>& edges) {
+        edges.clear();
+        if (p <= 0 || size < 2) {
+            return;
+        }
+        if (1 <= p) {
+            for (std::size_t v = 1; v < size; ++v) {
+                for (std::size_t w = 0; w < v; ++w) {
+                    edges.emplace_back(v, w);
+                }
+            }
+            return;
+        }
+
+        double log_q = std::log(1.0 - p);
+        double pairs = double(size) * double(size);
+        std::size_t v = 1;
+        std::int64_t w = -1;
+        while (v < size) {
+            double skip = std::floor(std::log(rng.uniform()) / log_q);
+            if (pairs < skip) {
+                break;
+            }
+            w += 1 + std::int64_t(skip);
+            while (std::int64_t(v) <= w && v < size) {
+                w -= v;
+                ++v;
+            }
+            if (v < size) {
+                edges.emplace_back(v, std::size_t(w));
+            }
+        }
+    }
+
+    // every vertex i is joined with i + o (mod size) for all offsets o, offset 1 gives a ring
+    inline void circulant(std::size_t size, const std::vector<std::size_t>& offsets, std::vector<Edge>& edges) {
+        edges.clear();
+        std::vector<bool> used(size * size, false);
+        for (std::size_t i = 0; i < size; ++i) {
+            for (auto &o : offsets) {
+                std::size_t j = (i + o) % size;
+                if (i != j && !used[i * size + j]) {
+                    used[i * size + j] = used[j * size + i] = true;
+                    edges.emplace_back(i, j);
+                }
+            }
+        }
+    }
+
+    // two groups of size / 2, vertex f of the first group is joined with vertices f + o of the second
+    inline void bipartite_circulant(std::size_t size, const std::vector<std::size_t>& offsets, std::vector<Edge>& edges) {
+        if (size % 2 != 0) {
+            throw "Error - bipartite circulant: size should be even";
+        }
+        edges.clear();
+        std::size_t group_size = size / 2;
+        std::vector<bool> used(group_size * group_size, false);
+        for (std::size_t f = 0; f < group_size; ++f) {
+            for (auto &o : offsets) {
+                std::size_t s = (f + o) % group_size;
+                if (!used[f * group_size + s]) {
+                    used[f * group_size + s] = true;
+                    edges.emplace_back(f, group_size + s);
+                }
+            }
+        }
+    }
+
+    // rows x cols grid, with periodic borders it is a torus
+    inline void grid(std::size_t rows, std::size_t cols, bool periodic, std::vector<Edge>& edges) {
+        edges.clear();
+        for (std::size_t r = 0; r < rows; ++r) {
+            for (std::size_t c = 0; c < cols; ++c) {
+                std::size_t v = r * cols + c;
+                if (c + 1 < cols) {
+                    edges.emplace_back(v, v + 1);
+                } else if (periodic && 2 < cols) {
+                    edges.emplace_back(v, r * cols);
+                }
+                if (r + 1 < rows) {
+                    edges.emplace_back(v, v + cols);
+                } else if (periodic && 2 < rows) {
+                    edges.emplace_back(v, c);
+                }
+            }
+        }
+    }
+
+    inline void hypercube(std::size_t dim, std::vector<Edge>& edges) {
+        edges.clear();
+        std::size_t size = std::size_t(1) << dim;
+        for (std::size_t v = 0; v < size; ++v) {
+            for (std::size_t b = 0; b < dim; ++b) {
+                std::size_t u = v ^ (std::size_t(1) << b);
+                if (v < u) {
+                    edges.emplace_back(v, u);
+                }
+            }
+        }
+    }
+
+    // groups of group_size vertices joined into rings, the first vertices of the groups (hubs)
+    // are joined pairwise and vertex 2 of every group is joined with vertex group_size - 2 of the next one
+    inline void clustered(std::size_t size, std::size_t group_cnt, bool hubs, bool cross, std::vector<Edge>& edges) {
+        if (group_cnt == 0 || size % group_cnt != 0) {
+            throw "Error - clustered graph: size should be divisible by groups count";
+        }
+        edges.clear();
+        std::size_t group_size = size / group_cnt;
+        if (2 < group_size) {
+            for (std::size_t j = 0; j < group_cnt; ++j) {
+                for (std::size_t i = 0; i < group_size; ++i) {
+                    edges.emplace_back(j * group_size + i, j * group_size + (i + 1) % group_size);
+                }
+            }
+        } else if (group_size == 2) {
+            for (std::size_t j = 0; j < group_cnt; ++j) {
+                edges.emplace_back(j * group_size, j * group_size + 1);
+            }
+        }
+        if (hubs) {
+            for (std::size_t i = 0; i < group_cnt; ++i) {
+                for (std::size_t j = i + 1; j < group_cnt; ++j) {
+                    edges.emplace_back(i * group_size, j * group_size);
+                }
+            }
+        }
+        if (cross && 4 <= group_size && 1 < group_cnt) {
+            for (std::size_t i = 0; i < group_cnt; ++i) {
+                std::size_t next = (i + 1) % group_cnt;
+                Edge link(i * group_size + 2, next * group_size + (group_size - 2));
+                // with two groups of 4 both links are the same edge
+                if (std::find(edges.begin(), edges.end(), link) == edges.end()) {
+                    edges.push_back(link);
+                }
+            }
+        }
+    }
+
+    // uniform-ish random degree-regular graph: points are paired one at a time avoiding loops and
+    // multi-edges (Steger, Wormald, 1999), the whole pairing is restarted when it gets stuck
+    template<class Rng>
+    void random_regular(std::size_t size, std::size_t degree, Rng& rng, std::vector<Edge>& edges) {
+        if (size <= degree || (size * degree) % 2 != 0) {
+            throw "Error - random regular graph: size * degree should be even and degree less than size";
+        }
+        std::vector<bool> adjacent(size * size);
+        std::vector<std::size_t> points;
+        while (true) {
+            edges.clear();
+            std::fill(adjacent.begin(), adjacent.end(), false);
+            points.clear();
+            for (std::size_t v = 0; v < size; ++v) {
+                for (std::size_t d = 0; d < degree; ++d) {
+                    points.push_back(v);
+                }
+            }
+
+            bool stuck = false;
+            while (!points.empty() && !stuck) {
+                stuck = true;
+                for (std::size_t attempt = 0; attempt < 8 * points.size(); ++attempt) {
+                    std::size_t a = rng.below(points.size());
+                    std::size_t b = rng.below(points.size());
+                    std::size_t u = points[a], v = points[b];
+                    if (a == b || u == v || adjacent[u * size + v]) {
+                        continue;
+                    }
+                    adjacent[u * size + v] = adjacent[v * size + u] = true;
+                    edges.emplace_back(u, v);
+                    // remove both points, larger index first so the smaller one stays valid
+                    std::size_t first = std::max(a, b), second = std::min(a, b);
+                    points[first] = points.back();
+                    points.pop_back();
+                    points[second] = points.back();
+                    points.pop_back();
+                    stuck = false;
+                    break;
+                }
+            }
+            if (points.empty()) {
+                return;
+            }
+        }
+    }
+}
@@ -1,8 +1,13 @@
+#pragma once
+
 #include <algorithm>
+#include <array>
 #include <iostream>
 #include <cmath>
 #include <cstddef>
 #include <ostream>
+#include <span>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -76,15 +81,37 @@ namespace graph {
 
 
 
+    // compressed sparse row form of an adjacency matrix: the neighbours of v are
+    // neighbours[offsets[v]] .. neighbours[offsets[v + 1] - 1] in increasing order
+    struct Adjacency {
+        std::vector<std::size_t> offsets;
+        std::vector<std::size_t> neighbours;
+        std::vector<std::size_t> degrees;
+
+        std::span<const std::size_t> operator[](std::size_t v) const {
+            return {neighbours.data() + offsets[v], degrees[v]};
+        }
+    };
+
+
     template<std::size_t size>
     class Graph {
     private:
         std::array<std::array<bool, size>, size> m;
 
-        long double _get_hash(std::size_t current, std::size_t parent,  std::vector<std::vector<std::size_t>> &graph) const {
+        // built on the first query after an edit, every edit goes through invalidate();
+        // not synchronised, a graph shared between threads must call adjacency() first
+        mutable Adjacency csr;
+        mutable bool csr_valid = false;
+
+        void invalidate() {
+            this->csr_valid = false;
+        }
+
+        long double _get_hash(std::size_t current, std::size_t parent, const Adjacency &graph) const {
             long double current_hash = HASH_BASE;
             std::vector<long double> sons_hash;
-            for (auto &u : graph[current]) {
+            for (auto u : graph[current]) {
                 if (u != parent) {
                    sons_hash.push_back(_get_hash(u, current, graph)); 
                 }
@@ -105,6 +132,15 @@ namespace graph {
             }
         }
 
+        // a copy starts without the view, it is built again on its first query
+        Graph(const Graph& other) : m(other.m) {}
+
+        Graph& operator=(const Graph& other) {
+            this->m = other.m;
+            this->invalidate();
+            return *this;
+        }
+
         Graph(std::vector<std::vector<bool>> &g) {
             if (g.size() != size) {
                 throw "Error - graph contructor: incorrect matrix-argument size";
@@ -196,27 +232,58 @@ namespace graph {
                     (this->m)[i][j] = !(this->m)[i][j];
                 }
             }
+            this->invalidate();
         }
 
         template<std::size_t nsize>
         friend bool operator~(const Graph<nsize>& graph);
 
         template<std::size_t nsize>
-        friend void dfs(std::size_t vertex, const Graph<nsize>& graph, std::vector<bool>& used);
+        friend void dfs(std::size_t vertex, const Graph<nsize>& graph, std::vector<int>& used);
+
+        const Adjacency& adjacency() const {
+            if (!this->csr_valid) {
+                auto &a = this->csr;
+                a.offsets.assign(size + 1, 0);
+                a.degrees.assign(size, 0);
+                a.neighbours.clear();
+                for (std::size_t i = 0; i < size; ++i) {
+                    for (std::size_t j = 0; j < size; ++j) {
+                        if ((this->m)[i][j]) {
+                            a.neighbours.push_back(j);
+                        }
+                    }
+                    a.offsets[i + 1] = a.neighbours.size();
+                    a.degrees[i] = a.offsets[i + 1] - a.offsets[i];
+                }
+                this->csr_valid = true;
+            }
+            return this->csr;
+        }
+
+        std::span<const std::size_t> neighbours(std::size_t v) const {
+            if (size <= v) {
+                throw "Error - graph neighbours: incorect index value";
+            }
+            return this->adjacency()[v];
+        }
+
+        std::size_t degree(std::size_t v) const {
+            if (size <= v) {
+                throw "Error - graph degree: incorect index value";
+            }
+            return this->adjacency().degrees[v];
+        }
 
         long double get_hash(std::size_t root) const {
-            auto self_modified = (*this).convert_to_list();
-            return _get_hash(root, root, self_modified);
+            return _get_hash(root, root, this->adjacency());
         }
 
         std::vector<std::vector<std::size_t>> convert_to_list() const {
+            auto &a = this->adjacency();
             std::vector<std::vector<std::size_t>> new_graph(size);
             for (std::size_t i = 0; i < size; ++i) {
-                for (std::size_t j = 0; j < size; ++j) {
-                    if ((*this)(i, j)) {
-                        new_graph[i].push_back(j);
-                    }
-                }
+                new_graph[i].assign(a[i].begin(), a[i].end());
             }
             return new_graph;
         }
@@ -226,14 +293,11 @@ namespace graph {
                                                                             std::pair<double, double> no_edge) const {
             std::vector<std::vector<std::pair<double, double>>> result(
                                                                         size,
-                                                                        std::vector<std::pair<double, double>> (size));
-            for (int i = 0; i < size; ++i) {
-                for (int j = 0; j < size; ++j) {
-                    if ((*this)(i, j)) {
-                        result[i][j] = edge;
-                    } else {
-                        result[i][j] = no_edge;
-                    }
+                                                                        std::vector<std::pair<double, double>> (size, no_edge));
+            auto &a = this->adjacency();
+            for (std::size_t i = 0; i < size; ++i) {
+                for (auto j : a[i]) {
+                    result[i][j] = edge;
                 }
             }
             return result;
@@ -268,9 +332,9 @@ namespace graph {
         bool operator%(const Graph<size>& other) {
             long double self_hash = get_hash(0);
 
-            auto other_modified = other.convert_to_list();
+            auto &other_adjacency = other.adjacency();
             for (std::size_t other_root = 0; other_root < size; ++other_root) {
-                if (self_hash == _get_hash(other_root, other_root, other_modified)) {
+                if (self_hash == _get_hash(other_root, other_root, other_adjacency)) {
                     return true;
                 }
             }
@@ -353,6 +417,7 @@ namespace graph {
         }
         graph.m[edge[0]][edge[1]] = true;
         graph.m[edge[1]][edge[0]] = true;
+        graph.invalidate();
         return graph;
     }
 
@@ -363,14 +428,15 @@ namespace graph {
         }
         graph.m[edge[0]][edge[1]] = false;
         graph.m[edge[1]][edge[0]] = false;
+        graph.invalidate();
         return graph;
     }
 
     template<std::size_t size>
     void dfs(std::size_t vertex, const Graph<size>& graph, std::vector<int>& used) {
         used[vertex] = true;
-        for (std::size_t i = 0; i < size; ++i) {
-            if (graph(vertex, i) && !used[i]) {
+        for (auto i : graph.adjacency()[vertex]) {
+            if (!used[i]) {
                 dfs(i, graph, used);
             }
         }
@@ -391,15 +457,14 @@ namespace graph {
     template<std::size_t size>
     std::ostream& operator<<(std::ostream& os, const Graph<size>& graph) {
         os << size << std::endl;
+        auto &a = graph.adjacency();
+        std::string row;
         for (std::size_t i = 0; i < size; ++i) {
-            for (std::size_t j = 0; j < size; ++j) {
-                if (graph(i, j)) {
-                    os << '1';
-                } else {
-                    os << '0';
-                }
+            row.assign(size, '0');
+            for (auto j : a[i]) {
+                row[j] = '1';
             }
-            os << std::endl;
+            os << row << std::endl;
         }
         return os;
     }
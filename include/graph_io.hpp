@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "graph.hpp"
+
+
+namespace graph {
+    // binary graph file (see convert_to_binary.cpp):
+    //   int32 count, then for every graph int32 size and size * size int32 adjacency entries
+    inline std::int64_t bin_graph_offset(std::int64_t step, std::int64_t size) {
+        return 4 + step * (4 + 4 * size * size);
+    }
+
+    inline void write_bin_count(std::ostream& os, std::int32_t count) {
+        os.write((char *)&count, 4);
+    }
+
+    // writes one graph given by its edge list, buffer is reused between calls
+    // and only the touched entries are cleared, so the cost besides the output itself is O(m)
+    inline void write_bin_graph(std::ostream& os, std::size_t size, const std::vector<Edge>& edges,
+                                std::vector<std::int32_t>& buffer) {
+        if (buffer.size() != size * size) {
+            buffer.assign(size * size, 0);
+        }
+        for (auto &e : edges) {
+            buffer[e[0] * size + e[1]] = 1;
+            buffer[e[1] * size + e[0]] = 1;
+        }
+
+        std::int32_t sz = size;
+        os.write((char *)&sz, 4);
+        os.write((char *)buffer.data(), 4 * buffer.size());
+
+        for (auto &e : edges) {
+            buffer[e[0] * size + e[1]] = 0;
+            buffer[e[1] * size + e[0]] = 0;
+        }
+    }
+
+    // opens a binary graph file for writing at arbitrary offsets, the file is created with its count header
+    inline std::fstream create_bin_file(const std::string& path, std::int32_t count) {
+        {
+            std::ofstream create(path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+            if (!create) {
+                throw "Error - binary graph file: couldn't open file for writing";
+            }
+            write_bin_count(create, count);
+        }
+        return std::fstream(path, std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+    }
+
+    // text graph format, the same layout operator<< prints for Graph<size>
+    inline void write_text_graph(std::ostream& os, std::size_t size, const std::vector<Edge>& edges) {
+        std::vector<std::string> rows(size, std::string(size, '0'));
+        for (auto &e : edges) {
+            rows[e[0]][e[1]] = '1';
+            rows[e[1]][e[0]] = '1';
+        }
+        os << size << std::endl;
+        for (auto &row : rows) {
+            os << row << std::endl;
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+
+namespace conductivity {
+    // Least squares non-decreasing fit of a series by pool adjacent violators: the fit is a stack of
+    // blocks holding the mean of their values, a new value is pushed as a block of its own and merged
+    // with the blocks below while their mean is larger, O(n) in total. Fitted values below lower are
+    // raised to it afterwards, the same as sklearn IsotonicRegression(increasing=True, y_min=lower).
+    // The block stack is kept between calls, one instance per thread.
+    class IsotonicFit {
+    private:
+        std::vector<double> sums;
+        std::vector<std::size_t> counts;
+
+    public:
+        void fit(const double *y, std::size_t n, double *result, double lower = -INFINITY) {
+            sums.clear();
+            counts.clear();
+            for (std::size_t j = 0; j < n; ++j) {
+                double sum = y[j];
+                std::size_t count = 1;
+                // mean of the top block above sum / count, compared without dividing
+                while (!sums.empty() && sum * counts.back() < sums.back() * count) {
+                    sum += sums.back();
+                    count += counts.back();
+                    sums.pop_back();
+                    counts.pop_back();
+                }
+                sums.push_back(sum);
+                counts.push_back(count);
+            }
+            std::size_t j = 0;
+            for (std::size_t b = 0; b < sums.size(); ++b) {
+                double mean = std::max(lower, sums[b] / counts[b]);
+                for (std::size_t k = 0; k < counts[b]; ++k) {
+                    result[j++] = mean;
+                }
+            }
+        }
+    };
+
+    // How far a series is from non-decreasing: the number of decreasing steps, the sum and the largest of
+    // their drops.
+    struct Monotonicity {
+        std::size_t violations = 0;
+        double total_drop = 0;
+        double largest_drop = 0;
+
+        Monotonicity(const double *y, std::size_t n) {
+            for (std::size_t j = 1; j < n; ++j) {
+                if (y[j] < y[j - 1]) {
+                    ++violations;
+                    total_drop += y[j - 1] - y[j];
+                    largest_drop = std::max(largest_drop, y[j - 1] - y[j]);
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "linalg.hpp"
+
+
+namespace linalg {
+    // exp(-i H t) v by Arnoldi projection on the Krylov subspace span{v, Hv, ..., H^(m-1) v}
+    // (Saad, 1992; Sidje, Expokit, 1998). H may be non-Hermitian (leaky cavities) and is any
+    // operator with dim() and apply(in, out), so CSR matrices and matrix-free Hamiltonians both work.
+    // Memory is (m + 1) vectors of the operator dimension.
+    //
+    // On a uniform time grid one basis serves many consecutive points: the projected vector is advanced
+    // with exp(-i H_m dt) and the basis is rebuilt only when the a posteriori error estimate
+    // beta * h_(m+1,m) * |e_m^T y| exceeds the tolerance. Between rebuilds the state is kept as
+    // beta * V y, so norms and single components cost O(m).
+    class KrylovPropagator {
+    private:
+        std::size_t m;
+        double tolerance;
+        std::vector<cvector> basis;
+        Matrix hessenberg;
+        cvector w;
+
+        std::size_t k;
+        double beta;
+        double h_next;
+        cvector y, y_next;
+
+        // builds the orthonormal basis of the Krylov subspace of psi, returns false for psi = 0
+        template<class Operator>
+        bool arnoldi(const Operator& h, const cvector& psi) {
+            std::size_t n = h.dim();
+            std::size_t dim = std::min(m, n);
+            beta = norm(psi);
+            if (beta == 0) {
+                return false;
+            }
+
+            basis.resize(dim + 1);
+            hessenberg = Matrix(dim, dim);
+            basis[0] = psi;
+            for (auto &x : basis[0]) {
+                x /= beta;
+            }
+
+            k = dim;
+            h_next = 0;
+            for (std::size_t j = 0; j < dim; ++j) {
+                h.apply(basis[j], w);
+                // Gram-Schmidt twice keeps the basis orthonormal to working precision,
+                // which matters because populations are read from norms in this basis
+                for (int pass = 0; pass < 2; ++pass) {
+                    for (std::size_t i = 0; i <= j; ++i) {
+                        complex c = dot(basis[i], w);
+                        hessenberg(i, j) += c;
+                        for (std::size_t q = 0; q < n; ++q) {
+                            w[q] -= c * basis[i][q];
+                        }
+                    }
+                }
+                h_next = norm(w);
+                if (h_next < 1e-13 * (1 + std::abs(hessenberg(j, j)))) {
+                    // invariant subspace found, the projection is exact
+                    k = j + 1;
+                    h_next = 0;
+                    break;
+                }
+                if (j + 1 < dim) {
+                    hessenberg(j + 1, j) = h_next;
+                    basis[j + 1] = w;
+                    for (auto &x : basis[j + 1]) {
+                        x /= h_next;
+                    }
+                }
+            }
+            if (k == n) {
+                h_next = 0;
+            }
+            return true;
+        }
+
+        Matrix step_matrix(double tau) const {
+            Matrix a(k, k);
+            for (std::size_t i = 0; i < k; ++i) {
+                for (std::size_t j = 0; j < k; ++j) {
+                    a(i, j) = complex(0, -tau) * hessenberg(i, j);
+                }
+            }
+            return expm(a);
+        }
+
+        double error(const cvector& coeffs) const {
+            return beta * h_next * std::abs(coeffs[k - 1]);
+        }
+
+        void reconstruct(cvector& psi) const {
+            std::fill(psi.begin(), psi.end(), complex(0));
+            for (std::size_t j = 0; j < k; ++j) {
+                complex c = beta * y[j];
+                for (std::size_t q = 0; q < psi.size(); ++q) {
+                    psi[q] += c * basis[j][q];
+                }
+            }
+        }
+
+    public:
+        KrylovPropagator(std::size_t m = 30, double tolerance = 1e-10) : m(m), tolerance(tolerance), k(0), beta(0), h_next(0) {}
+
+        // psi <- exp(-i H t) psi, the interval is split into substeps until every substep
+        // satisfies the error estimate
+        template<class Operator>
+        void propagate(const Operator& h, cvector& psi, double t) {
+            double done = 0;
+            double tau = t;
+            while (done < t) {
+                if (!arnoldi(h, psi)) {
+                    return;
+                }
+                tau = std::min(tau, t - done);
+                Matrix f;
+                while (true) {
+                    f = step_matrix(tau);
+                    y.assign(k, 0);
+                    for (std::size_t j = 0; j < k; ++j) {
+                        y[j] = f(j, 0);
+                    }
+                    if (error(y) <= tolerance * tau / t || tau < 1e-12 * t) {
+                        break;
+                    }
+                    tau /= 2;
+                }
+                reconstruct(psi);
+                done += tau;
+                // try a longer step next time if this one was limited by the error
+                tau = std::min(2 * tau, t - done);
+            }
+        }
+
+        // advances psi over steps intervals of length dt, callback(step) is called after every interval
+        // and may read the current state through norm2() and component(v); psi holds the final state
+        template<class Operator, class Callback>
+        void propagate_grid(const Operator& h, cvector& psi, double dt, std::size_t steps, Callback&& callback) {
+            std::size_t done = 0;
+            while (done < steps) {
+                if (!arnoldi(h, psi)) {
+                    y.assign(1, 0);
+                    k = 1;
+                    for (; done < steps; ++done) {
+                        callback(done + 1);
+                    }
+                    return;
+                }
+                Matrix f = step_matrix(dt);
+                y.assign(k, 0);
+                y[0] = 1;
+
+                std::size_t taken = 0;
+                while (done < steps) {
+                    f.apply(y, y_next);
+                    if (tolerance < error(y_next)) {
+                        break;
+                    }
+                    std::swap(y, y_next);
+                    ++taken;
+                    ++done;
+                    callback(done);
+                }
+                if (taken == 0) {
+                    // dt is too long for one basis of this size
+                    propagate(h, psi, dt);
+                    arnoldi(h, psi);
+                    y.assign(k, 0);
+                    y[0] = 1;
+                    ++done;
+                    callback(done);
+                    continue;
+                }
+                reconstruct(psi);
+            }
+        }
+
+        double norm2() const {
+            double s = 0;
+            for (std::size_t j = 0; j < k; ++j) {
+                s += std::norm(y[j]);
+            }
+            return beta * beta * s;
+        }
+
+        complex component(std::size_t v) const {
+            complex s = 0;
+            for (std::size_t j = 0; j < k; ++j) {
+                s += basis[j][v] * y[j];
+            }
+            return beta * s;
+        }
+    };
+}
@@ -0,0 +1,374 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+
+namespace linalg {
+    using complex = std::complex<double>;
+    using cvector = std::vector<complex>;
+
+    inline double norm(const cvector& v) {
+        double s = 0;
+        for (auto &x : v) {
+            s += std::norm(x);
+        }
+        return std::sqrt(s);
+    }
+
+    inline complex dot(const cvector& a, const cvector& b) {
+        complex s = 0;
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            s += std::conj(a[i]) * b[i];
+        }
+        return s;
+    }
+
+    // small dense complex matrix, row-major
+    class Matrix {
+    private:
+        std::size_t r, c;
+        cvector data;
+
+    public:
+        Matrix(std::size_t rows = 0, std::size_t cols = 0) : r(rows), c(cols), data(rows * cols, 0) {}
+
+        static Matrix identity(std::size_t n) {
+            Matrix m(n, n);
+            for (std::size_t i = 0; i < n; ++i) {
+                m(i, i) = 1;
+            }
+            return m;
+        }
+
+        std::size_t rows() const {
+            return r;
+        }
+
+        std::size_t cols() const {
+            return c;
+        }
+
+        complex& operator()(std::size_t i, std::size_t j) {
+            return data[i * c + j];
+        }
+
+        const complex& operator()(std::size_t i, std::size_t j) const {
+            return data[i * c + j];
+        }
+
+        Matrix operator*(const Matrix& other) const {
+            if (c != other.r) {
+                throw "Error - matrix product: incorrect matrix sizes";
+            }
+            Matrix result(r, other.c);
+            for (std::size_t i = 0; i < r; ++i) {
+                for (std::size_t k = 0; k < c; ++k) {
+                    complex a = (*this)(i, k);
+                    if (a == complex(0)) {
+                        continue;
+                    }
+                    for (std::size_t j = 0; j < other.c; ++j) {
+                        result(i, j) += a * other(k, j);
+                    }
+                }
+            }
+            return result;
+        }
+
+        Matrix& operator*=(complex x) {
+            for (auto &v : data) {
+                v *= x;
+            }
+            return *this;
+        }
+
+        Matrix& operator+=(const Matrix& other) {
+            for (std::size_t i = 0; i < data.size(); ++i) {
+                data[i] += other.data[i];
+            }
+            return *this;
+        }
+
+        void apply(const cvector& in, cvector& out) const {
+            out.assign(r, 0);
+            for (std::size_t i = 0; i < r; ++i) {
+                complex s = 0;
+                for (std::size_t j = 0; j < c; ++j) {
+                    s += (*this)(i, j) * in[j];
+                }
+                out[i] = s;
+            }
+        }
+
+        double norm1() const {
+            double result = 0;
+            for (std::size_t j = 0; j < c; ++j) {
+                double s = 0;
+                for (std::size_t i = 0; i < r; ++i) {
+                    s += std::abs((*this)(i, j));
+                }
+                result = std::max(result, s);
+            }
+            return result;
+        }
+    };
+
+    // exp(a) by scaling and squaring of the Taylor series, meant for the small matrices
+    // of Krylov subspaces and reduced systems
+    inline Matrix expm(const Matrix& a) {
+        std::size_t n = a.rows();
+        double nrm = a.norm1();
+        int squarings = 0;
+        if (0.5 < nrm) {
+            squarings = int(std::ceil(std::log2(nrm / 0.5)));
+        }
+        Matrix scaled = a;
+        scaled *= complex(std::ldexp(1.0, -squarings));
+
+        Matrix result = Matrix::identity(n);
+        Matrix term = Matrix::identity(n);
+        for (int k = 1; k <= 30; ++k) {
+            term = term * scaled;
+            term *= complex(1.0 / k);
+            result += term;
+            if (term.norm1() < 1e-17 * result.norm1()) {
+                break;
+            }
+        }
+        for (int s = 0; s < squarings; ++s) {
+            result = result * result;
+        }
+        return result;
+    }
+
+    // eigenvalues (ascending) and orthonormal eigenvectors (columns) of a Hermitian matrix, a = V diag(values) V^H,
+    // by cyclic Jacobi rotations: O(n^3) per sweep and accurate to working precision for the small
+    // reduced matrices it is meant for
+    inline void hermitian_eigen(Matrix a, std::vector<double>& values, Matrix& vectors) {
+        std::size_t n = a.rows();
+        vectors = Matrix::identity(n);
+        for (int sweep = 0; sweep < 100; ++sweep) {
+            double off = 0, total = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                for (std::size_t j = 0; j < n; ++j) {
+                    (i == j ? total : off) += std::norm(a(i, j));
+                }
+            }
+            if (off <= 1e-30 * (off + total)) {
+                break;
+            }
+            for (std::size_t p = 0; p < n; ++p) {
+                for (std::size_t q = p + 1; q < n; ++q) {
+                    double apq = std::abs(a(p, q));
+                    if (apq == 0) {
+                        continue;
+                    }
+                    // the phase of a_pq moves into column q, then a real rotation zeroes it
+                    complex e = a(p, q) / apq;
+                    double theta = (a(q, q).real() - a(p, p).real()) / (2 * apq);
+                    double t = (theta < 0 ? -1.0 : 1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1));
+                    double c = 1 / std::sqrt(t * t + 1), s = t * c;
+                    complex sp = s * e;
+
+                    for (std::size_t k = 0; k < n; ++k) {
+                        complex akp = a(k, p), akq = a(k, q);
+                        a(k, p) = c * akp - std::conj(sp) * akq;
+                        a(k, q) = sp * akp + c * akq;
+                    }
+                    for (std::size_t k = 0; k < n; ++k) {
+                        complex apk = a(p, k), aqk = a(q, k);
+                        a(p, k) = c * apk - sp * aqk;
+                        a(q, k) = std::conj(sp) * apk + c * aqk;
+                    }
+                    a(p, q) = a(q, p) = 0;
+                    for (std::size_t k = 0; k < n; ++k) {
+                        complex vkp = vectors(k, p), vkq = vectors(k, q);
+                        vectors(k, p) = c * vkp - std::conj(sp) * vkq;
+                        vectors(k, q) = sp * vkp + c * vkq;
+                    }
+                }
+            }
+        }
+
+        std::vector<std::size_t> order(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](std::size_t x, std::size_t y) {
+            return a(x, x).real() < a(y, y).real();
+        });
+        values.resize(n);
+        Matrix sorted(n, n);
+        for (std::size_t j = 0; j < n; ++j) {
+            values[j] = a(order[j], order[j]).real();
+            for (std::size_t i = 0; i < n; ++i) {
+                sorted(i, j) = vectors(i, order[j]);
+            }
+        }
+        vectors = sorted;
+    }
+
+    // the same by Householder reduction to a tridiagonal matrix, made real by a diagonal phase, and implicit QL
+    // iteration with Wilkinson shifts: about 10 n^3 flops in total against 30 n^3 per Jacobi sweep, for the
+    // full waveguide matrices of larger graphs. The eigenvectors are kept as rows (row k is column k of V)
+    // so that both the reflections and the rotations run along contiguous rows.
+    inline void hermitian_eigen_tridiagonal(Matrix a, std::vector<double>& values, Matrix& vectors) {
+        std::size_t n = a.rows();
+        Matrix z = Matrix::identity(n);
+        cvector v(n), w(n), u(n);
+        for (std::size_t k = 0; k + 2 < n; ++k) {
+            double tail = 0, x_norm = std::norm(a(k + 1, k));
+            for (std::size_t j = k + 2; j < n; ++j) {
+                tail += std::norm(a(j, k));
+            }
+            if (tail == 0) {
+                continue;
+            }
+            x_norm = std::sqrt(x_norm + tail);
+            // reflection H = I - 2 v v^H taking column k below the diagonal to alpha e_(k+1)
+            complex x0 = a(k + 1, k);
+            complex alpha = -(std::abs(x0) == 0 ? complex(1) : x0 / std::abs(x0)) * x_norm;
+            double v_norm = 0;
+            for (std::size_t j = k + 1; j < n; ++j) {
+                v[j] = a(j, k) - (j == k + 1 ? alpha : complex(0));
+                v_norm += std::norm(v[j]);
+            }
+            v_norm = std::sqrt(v_norm);
+            for (std::size_t j = k + 1; j < n; ++j) {
+                v[j] /= v_norm;
+            }
+            // H a H = a - 2 (v w^H + w v^H) with p = a v, w = p - (v^H p) v
+            complex kappa = 0;
+            for (std::size_t i = k + 1; i < n; ++i) {
+                double p_re = 0, p_im = 0;
+                for (std::size_t j = k + 1; j < n; ++j) {
+                    p_re += a(i, j).real() * v[j].real() - a(i, j).imag() * v[j].imag();
+                    p_im += a(i, j).real() * v[j].imag() + a(i, j).imag() * v[j].real();
+                }
+                complex p(p_re, p_im);
+                w[i] = p;
+                kappa += std::conj(v[i]) * p;
+            }
+            for (std::size_t i = k + 1; i < n; ++i) {
+                w[i] -= kappa.real() * v[i];
+            }
+            // the products are written out, complex operator* checks for infinities and does not vectorise
+            for (std::size_t i = k + 1; i < n; ++i) {
+                double vr = 2 * v[i].real(), vi = 2 * v[i].imag(), wr = 2 * w[i].real(), wi = 2 * w[i].imag();
+                for (std::size_t j = k + 1; j < n; ++j) {
+                    a(i, j) -= complex(vr * w[j].real() + vi * w[j].imag() + wr * v[j].real() + wi * v[j].imag(),
+                                       vi * w[j].real() - vr * w[j].imag() + wi * v[j].real() - wr * v[j].imag());
+                }
+            }
+            a(k + 1, k) = alpha;
+            a(k, k + 1) = std::conj(alpha);
+            for (std::size_t j = k + 2; j < n; ++j) {
+                a(j, k) = a(k, j) = 0;
+            }
+            // V = V H, row j of z is column j of V
+            std::fill(u.begin(), u.end(), complex(0));
+            for (std::size_t j = k + 1; j < n; ++j) {
+                for (std::size_t r = 0; r < n; ++r) {
+                    u[r] += complex(v[j].real() * z(j, r).real() - v[j].imag() * z(j, r).imag(),
+                                    v[j].real() * z(j, r).imag() + v[j].imag() * z(j, r).real());
+                }
+            }
+            for (std::size_t j = k + 1; j < n; ++j) {
+                complex c = 2.0 * std::conj(v[j]);
+                for (std::size_t r = 0; r < n; ++r) {
+                    z(j, r) -= complex(c.real() * u[r].real() - c.imag() * u[r].imag(),
+                                       c.real() * u[r].imag() + c.imag() * u[r].real());
+                }
+            }
+        }
+
+        // D^H T D with d_(k+1) = d_k phase(t_(k+1)k) has the real subdiagonal |t_(k+1)k|, V = V D
+        std::vector<double> d(n), e(n, 0);
+        complex phase = 1;
+        for (std::size_t k = 0; k < n; ++k) {
+            d[k] = a(k, k).real();
+            if (k != 0) {
+                complex b = a(k, k - 1);
+                e[k - 1] = std::abs(b);
+                if (e[k - 1] != 0) {
+                    phase *= b / e[k - 1];
+                }
+                for (std::size_t r = 0; r < n; ++r) {
+                    z(k, r) *= phase;
+                }
+            }
+        }
+
+        // implicit QL, e[i] couples d[i] and d[i + 1]
+        for (std::size_t l = 0; l < n; ++l) {
+            for (int iteration = 0;; ++iteration) {
+                std::size_t m = l;
+                for (; m + 1 < n; ++m) {
+                    double dd = std::abs(d[m]) + std::abs(d[m + 1]);
+                    if (std::abs(e[m]) <= 1e-16 * dd) {
+                        break;
+                    }
+                }
+                if (m == l) {
+                    break;
+                }
+                if (iteration == 60) {
+                    throw "Error - hermitian eigen: QL iteration does not converge";
+                }
+                double g = (d[l + 1] - d[l]) / (2 * e[l]);
+                double r = std::hypot(g, 1.0);
+                g = d[m] - d[l] + e[l] / (g + std::copysign(r, g));
+                double s = 1, c = 1, p = 0;
+                bool underflow = false;
+                for (std::size_t i = m; i-- > l;) {
+                    double f = s * e[i], b = c * e[i];
+                    e[i + 1] = r = std::hypot(f, g);
+                    if (r == 0) {
+                        d[i + 1] -= p;
+                        e[m] = 0;
+                        underflow = true;
+                        break;
+                    }
+                    s = f / r;
+                    c = g / r;
+                    g = d[i + 1] - p;
+                    r = (d[i] - g) * s + 2 * c * b;
+                    p = s * r;
+                    d[i + 1] = g + p;
+                    g = c * r - b;
+                    for (std::size_t k = 0; k < n; ++k) {
+                        complex next = z(i + 1, k);
+                        z(i + 1, k) = s * z(i, k) + c * next;
+                        z(i, k) = c * z(i, k) - s * next;
+                    }
+                }
+                if (underflow) {
+                    continue;
+                }
+                d[l] -= p;
+                e[l] = g;
+                e[m] = 0;
+            }
+        }
+
+        std::vector<std::size_t> order(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](std::size_t x, std::size_t y) {
+            return d[x] < d[y];
+        });
+        values.resize(n);
+        vectors = Matrix(n, n);
+        for (std::size_t j = 0; j < n; ++j) {
+            values[j] = d[order[j]];
+            for (std::size_t i = 0; i < n; ++i) {
+                vectors(i, j) = z(order[j], i);
+            }
+        }
+    }
+}
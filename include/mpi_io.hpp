@@ -0,0 +1,355 @@
+#pragma once
+
+#include <mpi.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "graph.hpp"
+#include "npy.hpp"
+#include "series_store.hpp"
+
+// MPI-IO of the binary graph files (int count, then per graph int size and size * size ints) and of the
+// result files (int n, int size, then fixed-size records of doubles) shared by the conductivity drivers
+
+inline void READ_n(MPI_File *fin, int *n, int *size) {
+    MPI_File_read_at(*fin, 0, n, 1, MPI_INT, MPI_STATUS_IGNORE);
+    MPI_File_read_at(*fin, 4, size, 1, MPI_INT, MPI_STATUS_IGNORE);
+}
+
+// reads one graph row by row and keeps only its edges
+inline void READ_graph(MPI_File *fin, int step, int size, std::vector<graph::Edge> &edges) {
+    MPI_Offset start_of_graph = 4 + MPI_Offset(step) * (4 + 4 * MPI_Offset(size) * size) + 4;
+    std::vector<int> row(size);
+    edges.clear();
+    for (int i = 0; i < size; ++i) {
+        MPI_File_read_at(*fin, start_of_graph + MPI_Offset(4) * i * size, row.data(), size, MPI_INT, MPI_STATUS_IGNORE);
+        for (int j = i + 1; j < size; ++j) {
+            if (row[j]) {
+                edges.emplace_back(std::size_t(i), std::size_t(j));
+            }
+        }
+    }
+}
+
+inline void WRITE_n(MPI_File *fout, int n, int size) {
+    MPI_File_write_at(*fout, 0, &n, 1, MPI_INT, MPI_STATUS_IGNORE);
+    MPI_File_write_at(*fout, 4, &size, 1, MPI_INT, MPI_STATUS_IGNORE);
+}
+
+// .npy header of a result file written instead of n and size, its length is the offset of record 0
+inline MPI_Offset WRITE_npy_header(MPI_File *fout, const std::vector<std::size_t> &shape, bool write) {
+    std::string header = npy::header(shape);
+    if (write) {
+        MPI_File_write_at(*fout, 0, header.data(), header.size(), MPI_CHAR, MPI_STATUS_IGNORE);
+    }
+    return header.size();
+}
+
+// record index of a file whose records all have the length of p and start after header bytes
+inline void WRITE_result(MPI_File *fout, MPI_Offset index, const std::vector<double> &p, MPI_Offset header = 8) {
+    MPI_Offset off = header + index * MPI_Offset(8 * p.size());
+    MPI_File_write_at(*fout, off, p.data(), p.size(), MPI_DOUBLE, MPI_STATUS_IGNORE);
+}
+
+// Graph reader with one graph of read-ahead: read() hands out a graph and posts the non-blocking read
+// of the next one the caller will ask for, so the file system works while the current graph is solved.
+// Graphs whose matrix is larger than MAX_AHEAD bytes are read row by row without read-ahead.
+class GraphReader {
+private:
+    static constexpr MPI_Offset MAX_AHEAD = MPI_Offset(1) << 26;
+
+    MPI_File *fin;
+    int size;
+    int pending = -1;
+    MPI_Request request;
+    std::vector<int> current, ahead;
+
+    MPI_Offset offset(int step) const {
+        return 4 + MPI_Offset(step) * (4 + 4 * MPI_Offset(size) * size) + 4;
+    }
+
+public:
+    GraphReader(MPI_File *fin, int size) : fin(fin), size(size) {
+        if (4 * MPI_Offset(size) * size <= MAX_AHEAD) {
+            current.resize(std::size_t(size) * size);
+            ahead.resize(std::size_t(size) * size);
+        }
+    }
+
+    GraphReader(const GraphReader&) = delete;
+    GraphReader& operator=(const GraphReader&) = delete;
+
+    ~GraphReader() {
+        if (pending != -1) {
+            MPI_Wait(&request, MPI_STATUS_IGNORE);
+        }
+    }
+
+    // edges of graph step; next is the step of the following call, -1 if there is none
+    void read(int step, int next, std::vector<graph::Edge> &edges) {
+        if (current.empty()) {
+            READ_graph(fin, step, size, edges);
+            return;
+        }
+        if (pending == step) {
+            MPI_Wait(&request, MPI_STATUS_IGNORE);
+            std::swap(current, ahead);
+        } else {
+            if (pending != -1) {
+                MPI_Wait(&request, MPI_STATUS_IGNORE);
+            }
+            MPI_File_read_at(*fin, offset(step), current.data(), current.size(), MPI_INT, MPI_STATUS_IGNORE);
+        }
+        pending = next;
+        if (next != -1) {
+            MPI_File_iread_at(*fin, offset(next), ahead.data(), ahead.size(), MPI_INT, &request);
+        }
+
+        edges.clear();
+        for (int i = 0; i < size; ++i) {
+            for (int j = i + 1; j < size; ++j) {
+                if (current[std::size_t(i) * size + j]) {
+                    edges.emplace_back(std::size_t(i), std::size_t(j));
+                }
+            }
+        }
+    }
+};
+
+// Write-behind for one result file: every record is copied into a buffer and written with a
+// non-blocking call, at most depth writes are in flight (two for double buffering) and the oldest
+// is completed before another is posted. flush() must be called before the file is closed.
+class ResultWriter {
+private:
+    MPI_File *fout;
+    MPI_Offset header;
+    std::size_t depth;
+    std::deque<std::pair<MPI_Request, std::vector<double>>> in_flight;
+    std::vector<std::vector<double>> spare;
+
+public:
+    ResultWriter(MPI_File *fout, MPI_Offset header = 8, std::size_t depth = 2)
+        : fout(fout), header(header), depth(depth) {}
+
+    ResultWriter(const ResultWriter&) = delete;
+    ResultWriter& operator=(const ResultWriter&) = delete;
+
+    ~ResultWriter() {
+        this->flush();
+    }
+
+    void write(MPI_Offset index, const std::vector<double> &p) {
+        while (depth <= in_flight.size()) {
+            MPI_Wait(&in_flight.front().first, MPI_STATUS_IGNORE);
+            spare.push_back(std::move(in_flight.front().second));
+            in_flight.pop_front();
+        }
+        std::vector<double> buffer;
+        if (!spare.empty()) {
+            buffer = std::move(spare.back());
+            spare.pop_back();
+        }
+        buffer.assign(p.begin(), p.end());
+
+        in_flight.emplace_back(MPI_REQUEST_NULL, std::move(buffer));
+        auto &[request, data] = in_flight.back();
+        MPI_Offset off = header + index * MPI_Offset(8 * data.size());
+        MPI_File_iwrite_at(*fout, off, data.data(), data.size(), MPI_DOUBLE, &request);
+    }
+
+    void flush() {
+        for (auto &[request, data] : in_flight) {
+            MPI_Wait(&request, MPI_STATUS_IGNORE);
+        }
+        in_flight.clear();
+    }
+};
+
+// Writer of a compressed series store (series_store.hpp) shared by all ranks. Encoded records are
+// buffered per rank; a full buffer takes the next free extent of the data section from a counter on
+// rank 0 (one MPI_Fetch_and_op, so ranks never wait for each other) and is written in one call,
+// followed by the index entries of its records. finish() is collective and writes the header.
+// A single rank keeps the counter itself, some MPI builds have no one-sided component for one process.
+class StoreWriter {
+private:
+    static constexpr std::size_t BATCH = std::size_t(1) << 20;
+
+    MPI_File *fout;
+    conductivity::StoreHeader header;
+    conductivity::SeriesCodec codec;
+    std::int64_t next_free = 0;
+    std::uint64_t written = 0;
+    MPI_Comm comm;
+    int world_size;
+    MPI_Win window;
+    std::vector<unsigned char> buffer;
+    std::vector<std::pair<MPI_Offset, conductivity::StoreEntry>> entries;
+
+public:
+    // collective over comm, the communicator fout was opened on; header holds everything but data_bytes,
+    // records never written read as missing
+    StoreWriter(MPI_File *fout, const conductivity::StoreHeader &header, MPI_Comm comm = MPI_COMM_WORLD)
+        : fout(fout), header(header), codec(header), comm(comm) {
+        MPI_File_set_size(*fout, 0);
+        MPI_Comm_size(comm, &world_size);
+        if (1 < world_size) {
+            MPI_Win_create(&next_free, sizeof(next_free), sizeof(next_free), MPI_INFO_NULL, comm, &window);
+        }
+    }
+
+    StoreWriter(const StoreWriter&) = delete;
+    StoreWriter& operator=(const StoreWriter&) = delete;
+
+    const conductivity::StoreHeader& get_header() const {
+        return header;
+    }
+
+    void write(MPI_Offset index, const std::vector<double> &p) {
+        std::size_t begin = buffer.size();
+        codec.encode(p, buffer);
+        entries.push_back({index, {begin, buffer.size() - begin}});
+        if (BATCH <= buffer.size()) {
+            this->flush();
+        }
+    }
+
+    void flush() {
+        if (entries.empty()) {
+            return;
+        }
+        std::int64_t length = buffer.size(), offset = next_free;
+        if (1 < world_size) {
+            MPI_Win_lock(MPI_LOCK_SHARED, 0, 0, window);
+            MPI_Fetch_and_op(&length, &offset, MPI_INT64_T, 0, 0, MPI_SUM, window);
+            MPI_Win_unlock(0, window);
+        } else {
+            next_free += length;
+        }
+
+        MPI_File_write_at(*fout, header.data_begin() + offset, buffer.data(), buffer.size(), MPI_BYTE, MPI_STATUS_IGNORE);
+        for (auto &[index, entry] : entries) {
+            entry.offset += offset;
+            MPI_File_write_at(*fout, sizeof(header) + 16 * index, &entry, sizeof(entry), MPI_BYTE, MPI_STATUS_IGNORE);
+        }
+        written += buffer.size();
+        buffer.clear();
+        entries.clear();
+    }
+
+    // collective, the file is cut to the length of the store
+    void finish() {
+        this->flush();
+        MPI_Allreduce(&written, &header.data_bytes, 1, MPI_UINT64_T, MPI_SUM, comm);
+        int rank;
+        MPI_Comm_rank(comm, &rank);
+        if (!rank) {
+            MPI_File_write_at(*fout, 0, &header, sizeof(header), MPI_BYTE, MPI_STATUS_IGNORE);
+        }
+        MPI_File_set_size(*fout, header.data_begin() + header.data_bytes);
+        if (1 < world_size) {
+            MPI_Win_free(&window);
+        }
+    }
+};
+
+// Block of per-graph data shared by the ranks of one node: MPI_Comm_split_type(MPI_COMM_TYPE_SHARED)
+// groups the ranks of a host and MPI_Win_allocate_shared puts the block in the memory of the node leader
+// (node rank 0), mapped by the other ranks. share(fill) is collective in the node: the leader fills the
+// block once for the node, the others wait for it and read the block in place. A node of a single rank
+// keeps a plain buffer. close() is collective and must come before MPI_Finalize.
+class NodeShared {
+private:
+    MPI_Comm node = MPI_COMM_NULL;
+    int node_rank = 0, node_size = 1;
+    MPI_Win window = MPI_WIN_NULL;
+    unsigned char *base = nullptr;
+    std::vector<unsigned char> own;
+
+public:
+    // collective over comm, the ranks of comm on one host share the block
+    explicit NodeShared(std::size_t bytes, MPI_Comm comm = MPI_COMM_WORLD) {
+        MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node);
+        MPI_Comm_rank(node, &node_rank);
+        MPI_Comm_size(node, &node_size);
+        if (node_size == 1) {
+            own.resize(bytes);
+            base = own.data();
+            return;
+        }
+        MPI_Win_allocate_shared(node_rank ? 0 : bytes, 1, MPI_INFO_NULL, node, &base, &window);
+        if (node_rank) {
+            MPI_Aint length;
+            int unit;
+            MPI_Win_shared_query(window, 0, &length, &unit, &base);
+        }
+        MPI_Win_lock_all(MPI_MODE_NOCHECK, window);
+    }
+
+    NodeShared(const NodeShared&) = delete;
+    NodeShared& operator=(const NodeShared&) = delete;
+
+    bool leader() const {
+        return node_rank == 0;
+    }
+
+    // ranks sharing the block
+    int ranks() const {
+        return node_size;
+    }
+
+    unsigned char *data() {
+        return base;
+    }
+
+    template<class Fill>
+    void share(Fill &&fill) {
+        if (node_size == 1) {
+            fill(base);
+            return;
+        }
+        // every rank is done with the previous contents
+        MPI_Barrier(node);
+        if (!node_rank) {
+            fill(base);
+        }
+        MPI_Win_sync(window);
+        MPI_Barrier(node);
+        MPI_Win_sync(window);
+    }
+
+    void close() {
+        if (window != MPI_WIN_NULL) {
+            MPI_Win_unlock_all(window);
+            MPI_Win_free(&window);
+        }
+        if (node != MPI_COMM_NULL) {
+            MPI_Comm_free(&node);
+        }
+    }
+
+    // bytes of an edge list of a graph of size vertices: the count, then the (i, j) pairs
+    static std::size_t edges_bytes(int size) {
+        return 8 * (1 + std::size_t(size) * (size - 1));
+    }
+
+    static void put_edges(unsigned char *block, const std::vector<graph::Edge> &edges) {
+        std::uint64_t *words = reinterpret_cast<std::uint64_t *>(block);
+        words[0] = edges.size();
+        for (std::size_t k = 0; k < edges.size(); ++k) {
+            words[1 + 2 * k] = edges[k][0];
+            words[2 + 2 * k] = edges[k][1];
+        }
+    }
+
+    static void get_edges(const unsigned char *block, std::vector<graph::Edge> &edges) {
+        const std::uint64_t *words = reinterpret_cast<const std::uint64_t *>(block);
+        edges.clear();
+        for (std::size_t k = 0; k < words[0]; ++k) {
+            edges.emplace_back(std::size_t(words[1 + 2 * k]), std::size_t(words[2 + 2 * k]));
+        }
+    }
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <vector>
+
+
+namespace npy {
+    // Header of a NumPy .npy file (format version 1.0) holding a C-ordered little-endian float64
+    // array of the given shape: magic, version, header length and the dictionary padded with spaces
+    // to a multiple of 64 bytes, so the data that follows is aligned and numpy.load(mmap_mode='r')
+    // maps it without copying.
+    inline std::string header(const std::vector<std::size_t>& shape) {
+        std::string dict = "{'descr': '<f8', 'fortran_order': False, 'shape': (";
+        for (std::size_t i = 0; i < shape.size(); ++i) {
+            dict += std::to_string(shape[i]) + (shape.size() == 1 ? "," : (i + 1 < shape.size() ? ", " : ""));
+        }
+        dict += "), }";
+
+        std::size_t prefix = 10;
+        std::size_t total = (prefix + dict.size() + 1 + 63) / 64 * 64;
+        if (65535 < total - prefix) {
+            throw "Error - npy header: shape is too long";
+        }
+        dict.append(total - prefix - dict.size() - 1, ' ');
+        dict += '\n';
+
+        std::size_t length = dict.size();
+        std::string result = "\x93NUMPY";
+        result += char(1);
+        result += char(0);
+        result += char(length & 0xff);
+        result += char(length >> 8);
+        return result + dict;
+    }
+
+    // shape of a .npy file of the kind header() describes (version 1.0 or 2.0) and the offset of its data
+    inline std::vector<std::size_t> read_header(std::istream& in, std::size_t& data_offset) {
+        char prefix[12];
+        if (!in.read(prefix, 8) || std::string(prefix, 6) != "\x93NUMPY" || (prefix[6] != 1 && prefix[6] != 2)) {
+            throw "Error - npy header: not a .npy file";
+        }
+        std::size_t prefix_size = prefix[6] == 1 ? 10 : 12;
+        if (!in.read(prefix + 8, prefix_size - 8)) {
+            throw "Error - npy header: truncated header";
+        }
+        std::size_t length = 0;
+        for (std::size_t i = prefix_size; i-- > 8;) {
+            length = length << 8 | (unsigned char) prefix[i];
+        }
+        std::string dict(length, ' ');
+        if (!in.read(dict.data(), length)) {
+            throw "Error - npy header: truncated header";
+        }
+        if (dict.find("'descr': '<f8'") == std::string::npos || dict.find("'fortran_order': False") == std::string::npos) {
+            throw "Error - npy header: only C-ordered little-endian float64 arrays are supported";
+        }
+
+        std::size_t open = dict.find("'shape': ("), close = dict.find(')', open);
+        if (open == std::string::npos || close == std::string::npos) {
+            throw "Error - npy header: no shape";
+        }
+        std::vector<std::size_t> shape;
+        for (std::size_t pos = open + 10; pos < close;) {
+            std::size_t next = std::min(dict.find(',', pos), close);
+            if (dict.find_first_not_of(' ', pos) < next) {
+                shape.push_back(std::stoull(dict.substr(pos, next - pos)));
+            }
+            pos = next + 1;
+        }
+        data_offset = prefix_size + length;
+        return shape;
+    }
+}
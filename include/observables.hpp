@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "conductivity.hpp"
+
+
+namespace conductivity {
+    // Scalar observables of a sink population series, accumulated point by point in O(1) memory so that
+    // one solve serves every output: the final value, the first time the series reaches threshold
+    // (linear interpolation, -1 if never), the area under the curve (trapezoids) and the largest
+    // transfer rate d sink / dt with the middle of the interval where it occurs.
+    class SeriesSummary {
+    private:
+        double threshold;
+        std::vector<double> t;
+        std::size_t count = 0;
+        double last = 0, area = 0, crossing = -1, rate = 0, rate_time = 0;
+
+    public:
+        SeriesSummary(const Parameters& params, double threshold) : threshold(threshold), t(time_grid(params)) {}
+
+        // values come in grid order
+        void add(double value) {
+            std::size_t j = count++;
+            if (j != 0) {
+                double dt = t[j] - t[j - 1];
+                area += dt * (value + last) / 2;
+                if (0 < dt && rate < (value - last) / dt) {
+                    rate = (value - last) / dt;
+                    rate_time = (t[j] + t[j - 1]) / 2;
+                }
+                if (crossing < 0 && last < threshold && threshold <= value) {
+                    crossing = t[j - 1] + dt * (threshold - last) / (value - last);
+                }
+            } else if (threshold <= value) {
+                crossing = t[0];
+            }
+            last = value;
+        }
+
+        void add(const std::vector<double>& series) {
+            for (double value : series) {
+                this->add(value);
+            }
+        }
+
+        double final_value() const {
+            return last;
+        }
+
+        double threshold_time() const {
+            return crossing;
+        }
+
+        double integral() const {
+            return area;
+        }
+
+        double peak_rate() const {
+            return rate;
+        }
+
+        double peak_time() const {
+            return rate_time;
+        }
+    };
+}
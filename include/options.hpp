@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+
+namespace cli {
+    // "--key value" command line options, a key without value is stored as "1"
+    class Options {
+    private:
+        std::map<std::string, std::string> named;
+        std::vector<std::string> positional;
+
+    public:
+        Options(int argc, char *argv[]) : Options(std::vector<std::string>(argv + std::min(argc, 1), argv + argc)) {}
+
+        // the arguments without the program name; a repeated key keeps its last value
+        explicit Options(const std::vector<std::string>& args) {
+            for (std::size_t i = 0; i < args.size(); ++i) {
+                const std::string& arg = args[i];
+                if (arg.size() > 2 && arg[0] == '-' && arg[1] == '-') {
+                    std::string key = arg.substr(2);
+                    std::string value = "1";
+                    if (i + 1 < args.size() && args[i + 1].rfind("--", 0) != 0) {
+                        value = args[++i];
+                    }
+                    named[key] = value;
+                } else {
+                    positional.push_back(arg);
+                }
+            }
+        }
+
+        bool has(const std::string& key) const {
+            return named.count(key) != 0;
+        }
+
+        std::string get(const std::string& key, const std::string& def) const {
+            auto it = named.find(key);
+            return it == named.end() ? def : it->second;
+        }
+
+        std::string get(const std::string& key) const {
+            auto it = named.find(key);
+            if (it == named.end()) {
+                throw "Error - options: required option is missing";
+            }
+            return it->second;
+        }
+
+        long long get_int(const std::string& key, long long def) const {
+            return has(key) ? std::stoll(get(key)) : def;
+        }
+
+        long long get_int(const std::string& key) const {
+            return std::stoll(get(key));
+        }
+
+        double get_double(const std::string& key, double def) const {
+            return has(key) ? std::stod(get(key)) : def;
+        }
+
+        double get_double(const std::string& key) const {
+            return std::stod(get(key));
+        }
+
+        std::size_t positional_count() const {
+            return positional.size();
+        }
+
+        const std::string& operator[](std::size_t idx) const {
+            if (positional.size() <= idx) {
+                throw "Error - options: incorrect positional argument index";
+            }
+            return positional[idx];
+        }
+    };
+}
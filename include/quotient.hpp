@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "conductivity.hpp"
+#include "graph.hpp"
+#include "sparse.hpp"
+
+
+namespace conductivity {
+    // Reduction of the one-photon problem to the quotient of the coarsest equitable partition in which
+    // start and finish are cells of their own. Every vertex of cell i has b_ij neighbours in cell j, so
+    // the normalized cell indicators span an invariant subspace of the adjacency matrix where it acts
+    // as sqrt(b_ij * b_ji); the photon starts and leaks in singleton cells and never leaves that
+    // subspace, so the sink population of the quotient is exact. The partition is the stable colouring
+    // of colour refinement from {start}, {finish} and the rest. Waveguides must be real (sin(phase) = 0),
+    // a complex phase depends on the orientation of the edges, which the partition does not respect.
+    class EquitableQuotient {
+    private:
+        std::size_t cells = 0;
+        std::size_t start_cell = 0, finish_cell = 0;
+        std::vector<std::size_t> colour;
+        // (cell i, cell j, b_ij) for b_ij != 0, sorted
+        std::vector<std::pair<std::pair<std::size_t, std::size_t>, std::size_t>> counts;
+
+    public:
+        static bool applicable(const Parameters& params) {
+            return std::abs(std::sin(params.phase)) <= 1e-12;
+        }
+
+        // false if the partition has more than max_cells cells, the refinement stops as soon as it does
+        bool build(std::size_t size, const std::vector<graph::Edge>& edges, std::size_t start, std::size_t finish,
+                   std::size_t max_cells) {
+            std::vector<std::vector<std::size_t>> adjacency(size);
+            for (auto &e : edges) {
+                if (e[0] != e[1]) {
+                    adjacency[e[0]].push_back(e[1]);
+                    adjacency[e[1]].push_back(e[0]);
+                }
+            }
+
+            colour.assign(size, 2);
+            colour[start] = 0;
+            colour[finish] = 1;
+            cells = start == finish ? 2 : 3;
+            std::vector<std::size_t> order(size), signature_begin(size + 1), signatures;
+            while (true) {
+                if (max_cells < cells) {
+                    return false;
+                }
+                // signature of a vertex: its colour and the sorted colours of its neighbours
+                signatures.clear();
+                for (std::size_t v = 0; v < size; ++v) {
+                    signature_begin[v] = signatures.size();
+                    signatures.push_back(colour[v]);
+                    std::size_t first = signatures.size();
+                    for (auto u : adjacency[v]) {
+                        signatures.push_back(colour[u]);
+                    }
+                    std::sort(signatures.begin() + first, signatures.end());
+                }
+                signature_begin[size] = signatures.size();
+                auto less = [&](std::size_t a, std::size_t b) {
+                    return std::lexicographical_compare(signatures.begin() + signature_begin[a], signatures.begin() + signature_begin[a + 1],
+                                                        signatures.begin() + signature_begin[b], signatures.begin() + signature_begin[b + 1]);
+                };
+                for (std::size_t v = 0; v < size; ++v) {
+                    order[v] = v;
+                }
+                std::sort(order.begin(), order.end(), less);
+
+                std::vector<std::size_t> refined(size);
+                std::size_t next_cells = 0;
+                for (std::size_t k = 0; k < size; ++k) {
+                    if (k != 0 && less(order[k - 1], order[k])) {
+                        ++next_cells;
+                    }
+                    refined[order[k]] = next_cells;
+                }
+                ++next_cells;
+                colour = refined;
+                if (next_cells == cells) {
+                    break;
+                }
+                cells = next_cells;
+            }
+            start_cell = colour[start];
+            finish_cell = colour[finish];
+
+            // b_ij from one representative of every cell
+            std::vector<std::size_t> representative(cells, size);
+            for (std::size_t v = 0; v < size; ++v) {
+                if (representative[colour[v]] == size) {
+                    representative[colour[v]] = v;
+                }
+            }
+            counts.clear();
+            std::vector<std::size_t> row(cells, 0);
+            for (std::size_t i = 0; i < cells; ++i) {
+                for (auto u : adjacency[representative[i]]) {
+                    ++row[colour[u]];
+                }
+                for (std::size_t j = 0; j < cells; ++j) {
+                    if (row[j]) {
+                        counts.push_back({{i, j}, row[j]});
+                        row[j] = 0;
+                    }
+                }
+            }
+            return true;
+        }
+
+        std::size_t dim() const {
+            return cells;
+        }
+
+        std::size_t start() const {
+            return start_cell;
+        }
+
+        std::size_t finish() const {
+            return finish_cell;
+        }
+
+        // cell of every vertex
+        const std::vector<std::size_t>& cell_of() const {
+            return colour;
+        }
+
+        // the effective Hamiltonian of hamiltonian() restricted to the symmetric subspace
+        linalg::CsrMatrix hamiltonian(const Parameters& params) const {
+            std::vector<std::pair<std::pair<std::size_t, std::size_t>, complex>> entries;
+            entries.reserve(counts.size() + 1);
+            double hop = params.coupling * std::cos(params.phase);
+            for (auto &[ij, count] : counts) {
+                auto [i, j] = ij;
+                // counts are sorted by cells, b_ji exists because adjacency is symmetric
+                auto back = std::lower_bound(counts.begin(), counts.end(), std::make_pair(std::make_pair(j, i), std::size_t(0)));
+                entries.push_back({{i, j}, hop * std::sqrt(double(count) * double(back->second))});
+            }
+            entries.push_back({{finish_cell, finish_cell}, complex(0, -params.leak / 2)});
+            return linalg::CsrMatrix(cells, entries);
+        }
+    };
+}
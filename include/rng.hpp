@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace graph {
+    // Philox4x32-10 counter-based generator (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+    // Output depends only on (seed, stream, position), so every graph of an ensemble gets its own stream
+    // and the result does not depend on how the graphs are distributed between threads or ranks.
+    class Philox {
+    private:
+        static constexpr std::uint32_t M0 = 0xD2511F53;
+        static constexpr std::uint32_t M1 = 0xCD9E8D57;
+        static constexpr std::uint32_t W0 = 0x9E3779B9;
+        static constexpr std::uint32_t W1 = 0xBB67AE85;
+
+        std::array<std::uint32_t, 2> key;
+        std::array<std::uint32_t, 4> counter;
+        std::array<std::uint32_t, 4> block;
+        std::size_t used;
+
+        void generate_block() {
+            std::array<std::uint32_t, 4> c = counter;
+            std::array<std::uint32_t, 2> k = key;
+            for (int round = 0; round < 10; ++round) {
+                std::uint64_t p0 = std::uint64_t(M0) * c[0];
+                std::uint64_t p1 = std::uint64_t(M1) * c[2];
+                c = {std::uint32_t(p1 >> 32) ^ c[1] ^ k[0], std::uint32_t(p1),
+                     std::uint32_t(p0 >> 32) ^ c[3] ^ k[1], std::uint32_t(p0)};
+                k[0] += W0;
+                k[1] += W1;
+            }
+            block = c;
+            used = 0;
+
+            // 64-bit block index lives in the first two counter words, the stream id in the last two
+            if (++counter[0] == 0) {
+                ++counter[1];
+            }
+        }
+
+    public:
+        using result_type = std::uint64_t;
+
+        Philox(std::uint64_t seed, std::uint64_t stream = 0) {
+            key = {std::uint32_t(seed), std::uint32_t(seed >> 32)};
+            counter = {0, 0, std::uint32_t(stream), std::uint32_t(stream >> 32)};
+            used = block.size();
+        }
+
+        static constexpr result_type min() {
+            return 0;
+        }
+
+        static constexpr result_type max() {
+            return ~result_type(0);
+        }
+
+        result_type operator()() {
+            if (used + 2 > block.size()) {
+                generate_block();
+            }
+            result_type value = (result_type(block[used]) << 32) | block[used + 1];
+            used += 2;
+            return value;
+        }
+
+        // uniform double in (0, 1]
+        double uniform() {
+            return double(((*this)() >> 11) + 1) * 0x1.0p-53;
+        }
+
+        // uniform integer in [0, bound)
+        std::uint64_t below(std::uint64_t bound) {
+            // Lemire's multiply-shift with rejection of the biased low range
+            std::uint64_t x = (*this)();
+            unsigned __int128 m = (unsigned __int128)(x) * bound;
+            std::uint64_t low = std::uint64_t(m);
+            if (low < bound) {
+                std::uint64_t threshold = -bound % bound;
+                while (low < threshold) {
+                    x = (*this)();
+                    m = (unsigned __int128)(x) * bound;
+                    low = std::uint64_t(m);
+                }
+            }
+            return std::uint64_t(m >> 64);
+        }
+    };
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "graph.hpp"
+#include "rng.hpp"
+
+
+namespace conductivity {
+    // Stratified sample of the ordered (start, finish) pairs of one graph for the distribution of a pair
+    // observable. Strata are the graph distances (unreachable pairs form the last one); every stratum is
+    // shuffled once and read in order, so pairs are drawn without replacement. Batches are allocated
+    // proportionally to the stratum sizes with at least two pairs per stratum. The CDF at x is estimated
+    // by sum W_h F_h(x) with W_h = N_h / N and the variance sum W_h^2 (1 - n_h / N_h) p_h (1 - p_h) / (n_h - 1);
+    // histogram bins use the same formula and quantile intervals invert the CDF interval (Woodruff).
+    class StratifiedSampler {
+    private:
+        std::vector<std::vector<std::pair<std::size_t, std::size_t>>> strata;
+        std::vector<std::vector<double>> values;
+        std::vector<std::size_t> handed;
+        std::size_t total = 0;
+        double z;
+
+        // estimate and standard error of the probability that a value lies in [lo, hi)
+        std::pair<double, double> probability(double lo, double hi) const {
+            double p = 0, variance = 0;
+            for (std::size_t h = 0; h < strata.size(); ++h) {
+                std::size_t n = values[h].size(), big_n = strata[h].size();
+                if (n == 0) {
+                    continue;
+                }
+                std::size_t inside = 0;
+                for (double v : values[h]) {
+                    inside += lo <= v && v < hi;
+                }
+                double w = double(big_n) / double(total);
+                double p_h = double(inside) / double(n);
+                p += w * p_h;
+                if (n < big_n) {
+                    // a single draw says nothing about the spread, take the largest one
+                    double spread = n < 2 ? 0.25 : p_h * (1 - p_h) * double(n) / double(n - 1);
+                    variance += w * w * (1 - double(n) / double(big_n)) * spread / double(n);
+                }
+            }
+            return {p, std::sqrt(variance)};
+        }
+
+        // smallest sampled value whose estimated CDF reaches level
+        double inverse(double level) const {
+            std::vector<std::pair<double, double>> weighted;
+            for (std::size_t h = 0; h < strata.size(); ++h) {
+                for (double v : values[h]) {
+                    weighted.push_back({v, double(strata[h].size()) / double(total) / double(values[h].size())});
+                }
+            }
+            std::sort(weighted.begin(), weighted.end());
+            double cumulative = 0;
+            for (auto &[v, w] : weighted) {
+                cumulative += w;
+                if (level <= cumulative + 1e-12) {
+                    return v;
+                }
+            }
+            return weighted.empty() ? 0 : weighted.back().first;
+        }
+
+    public:
+        // z of the two-sided confidence intervals, 1.96 for 95%
+        StratifiedSampler(std::size_t size, const std::vector<graph::Edge>& edges, std::uint64_t seed,
+                          std::uint64_t stream, double z = 1.96) : z(z) {
+            std::vector<std::vector<std::size_t>> adjacency(size);
+            for (auto &e : edges) {
+                adjacency[e[0]].push_back(e[1]);
+                adjacency[e[1]].push_back(e[0]);
+            }
+            std::vector<std::size_t> distance(size), queue(size);
+            std::vector<std::pair<std::size_t, std::size_t>> unreachable;
+            for (std::size_t s = 0; s < size; ++s) {
+                std::fill(distance.begin(), distance.end(), size);
+                distance[s] = 0;
+                std::size_t head = 0, tail = 0;
+                queue[tail++] = s;
+                while (head < tail) {
+                    std::size_t v = queue[head++];
+                    for (auto u : adjacency[v]) {
+                        if (distance[u] == size) {
+                            distance[u] = distance[v] + 1;
+                            queue[tail++] = u;
+                        }
+                    }
+                }
+                for (std::size_t f = 0; f < size; ++f) {
+                    if (f == s) {
+                        continue;
+                    }
+                    if (distance[f] == size) {
+                        unreachable.push_back({s, f});
+                        continue;
+                    }
+                    if (strata.size() < distance[f]) {
+                        strata.resize(distance[f]);
+                    }
+                    strata[distance[f] - 1].push_back({s, f});
+                }
+            }
+            if (!unreachable.empty()) {
+                strata.push_back(unreachable);
+            }
+            strata.erase(std::remove_if(strata.begin(), strata.end(), [](const auto& s) {
+                return s.empty();
+            }), strata.end());
+
+            graph::Philox rng(seed, stream);
+            for (auto &stratum : strata) {
+                for (std::size_t i = stratum.size(); 1 < i; --i) {
+                    std::swap(stratum[i - 1], stratum[rng.below(i)]);
+                }
+                total += stratum.size();
+            }
+            values.resize(strata.size());
+            handed.assign(strata.size(), 0);
+        }
+
+        std::size_t pairs() const {
+            return total;
+        }
+
+        std::size_t solves() const {
+            std::size_t result = 0;
+            for (auto &v : values) {
+                result += v.size();
+            }
+            return result;
+        }
+
+        bool exhausted() const {
+            return this->solves() == total;
+        }
+
+        // about count more pairs to solve, proportional to the strata and at least two per stratum
+        std::vector<std::pair<std::size_t, std::size_t>> next_batch(std::size_t count) {
+            std::size_t target = std::min(total, this->solves() + count);
+            std::vector<std::pair<std::size_t, std::size_t>> batch;
+            for (std::size_t h = 0; h < strata.size(); ++h) {
+                std::size_t want = std::size_t(std::ceil(double(target) * double(strata[h].size()) / double(total)));
+                want = std::min(strata[h].size(), std::max<std::size_t>({want, 2, values[h].size()}));
+                handed[h] = want - values[h].size();
+                batch.insert(batch.end(), strata[h].begin() + values[h].size(), strata[h].begin() + want);
+            }
+            return batch;
+        }
+
+        // values of the last batch in its order
+        void add(const std::vector<double>& batch_values) {
+            std::size_t k = 0;
+            for (std::size_t h = 0; h < strata.size(); ++h) {
+                values[h].insert(values[h].end(), batch_values.begin() + k, batch_values.begin() + k + handed[h]);
+                k += handed[h];
+                handed[h] = 0;
+            }
+        }
+
+        // half-width of the confidence interval of the CDF at x
+        double cdf_half_width(double x) const {
+            return z * this->probability(-INFINITY, std::nextafter(x, INFINITY)).second;
+        }
+
+        // value of quantile level with its confidence interval
+        std::array<double, 3> quantile(double level) const {
+            std::size_t n = this->solves();
+            if (n == 0) {
+                return {0, 0, 0};
+            }
+            double x = this->inverse(level);
+            double half = this->cdf_half_width(x);
+            return {x, this->inverse(std::max(0.0, level - half)), this->inverse(std::min(1.0, level + half))};
+        }
+
+        // probability of [lo, hi) with the half-width of its confidence interval
+        std::pair<double, double> bin(double lo, double hi) const {
+            auto [p, se] = this->probability(lo, hi);
+            return {p, z * se};
+        }
+
+        // largest sampled value
+        double max_value() const {
+            double result = 0;
+            for (auto &v : values) {
+                for (double x : v) {
+                    result = std::max(result, x);
+                }
+            }
+            return result;
+        }
+    };
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "conductivity.hpp"
+#include "graph.hpp"
+#include "linalg.hpp"
+
+
+namespace conductivity {
+    // Screen of all ordered pairs of one graph by the closed quantum walk with the hopping Hamiltonian
+    // H = g A (A the waveguide matrix, no leak), from one eigen-decomposition H = V diag(lambda) V^H.
+    // With P_l = sum over the eigenvalues of level l of v_k v_k^H the amplitude is
+    //   <finish| exp(-i H t) |start> = sum_l exp(-i lambda_l t) P_l(finish, start)
+    // and for every pair at once:
+    //   bound    (sum_l |P_l(f, s)|)^2, the supremum of |amplitude|^2 over t >= 0 when the levels are
+    //            rationally independent and an upper bound of it otherwise
+    //   average  sum_l |P_l(f, s)|^2, the infinite time average of |amplitude|^2
+    //   peak     the largest |amplitude|^2 on linspace(0, t_max, points) and its time
+    // The sums run over real and imaginary parts in separate row-major arrays, so the inner loops are
+    // contiguous axpys: O(n^3) for bound and average and O(n^3) per grid point for the peak.
+    // The screen is a heuristic for the leaky transfer: the bound holds for the closed walk only, and the
+    // sink population of a pair can exceed it (a leaf to leaf pair of an 11-vertex star has bound 0.04 and
+    // final population 0.11 with leak 1 and t_max 3000), so a threshold on it can drop pairs that transfer.
+    // The records of all pairs form one table, which can be built into memory shared with other ranks and
+    // attached there without building it again.
+    class WalkScreen {
+    private:
+        std::size_t n = 0;
+        // V split into parts, V^H rows (conjugated columns of V) for the axpys
+        std::vector<double> v_re, v_im, w_re, w_im;
+        // V is real for real waveguides, the imaginary parts are then skipped
+        bool real = false;
+        std::vector<double> lambda;
+        // first eigenvalue of every level and the end
+        std::vector<std::size_t> level_begin;
+        // RECORD doubles per pair, row finish and column start
+        std::vector<double> own;
+        const double *table = nullptr;
+
+        // row f of sum over k in [begin, end) of c_k v_k v_k^H, c_k = (c_re, c_im)[k]
+        void row_sum(std::size_t f, std::size_t begin, std::size_t end, const double *c_re, const double *c_im,
+                     double *re, double *im) const {
+            std::fill(re, re + n, 0.0);
+            std::fill(im, im + n, 0.0);
+            for (std::size_t k = begin; k < end; ++k) {
+                double x_re = v_re[f * n + k] * c_re[k] - v_im[f * n + k] * c_im[k];
+                double x_im = v_re[f * n + k] * c_im[k] + v_im[f * n + k] * c_re[k];
+                const double *a = w_re.data() + k * n, *b = w_im.data() + k * n;
+                if (real) {
+                    for (std::size_t s = 0; s < n; ++s) {
+                        re[s] += x_re * a[s];
+                        im[s] += x_im * a[s];
+                    }
+                    continue;
+                }
+                for (std::size_t s = 0; s < n; ++s) {
+                    re[s] += x_re * a[s] - x_im * b[s];
+                    im[s] += x_re * b[s] + x_im * a[s];
+                }
+            }
+        }
+
+    public:
+        static constexpr std::size_t RECORD = 4;
+
+        WalkScreen() {}
+
+        WalkScreen(std::size_t size, const std::vector<graph::Edge>& edges, const Parameters& params,
+                   std::size_t points) {
+            this->build(size, edges, params, points);
+        }
+
+        // doubles of the table of a graph
+        static std::size_t table_size(std::size_t size) {
+            return RECORD * size * size;
+        }
+
+        void build(std::size_t size, const std::vector<graph::Edge>& edges, const Parameters& params,
+                   std::size_t points) {
+            own.resize(table_size(size));
+            this->build(size, edges, params, points, own.data());
+        }
+
+        // into out of table_size(size) doubles, which must outlive the screen;
+        // points = 0 skips the grid peak, peak and its time are then -1
+        void build(std::size_t size, const std::vector<graph::Edge>& edges, const Parameters& params,
+                   std::size_t points, double *out) {
+            n = size;
+            table = out;
+            linalg::Matrix h(n, n), vectors;
+            complex hop = std::polar(params.coupling, params.phase);
+            // polar(g, 2 pi) has an imaginary part of 1e-17, which would make V complex
+            if (std::abs(std::sin(params.phase)) <= 1e-12) {
+                hop = hop.real();
+            }
+            for (auto &e : edges) {
+                std::size_t i = std::min(e[0], e[1]), j = std::max(e[0], e[1]);
+                if (i != j) {
+                    h(i, j) = hop;
+                    h(j, i) = std::conj(hop);
+                }
+            }
+            linalg::hermitian_eigen_tridiagonal(h, lambda, vectors);
+
+            real = true;
+            v_re.resize(n * n);
+            v_im.resize(n * n);
+            w_re.resize(n * n);
+            w_im.resize(n * n);
+            for (std::size_t i = 0; i < n; ++i) {
+                for (std::size_t k = 0; k < n; ++k) {
+                    v_re[i * n + k] = w_re[k * n + i] = vectors(i, k).real();
+                    v_im[i * n + k] = vectors(i, k).imag();
+                    w_im[k * n + i] = -vectors(i, k).imag();
+                    real = real && vectors(i, k).imag() == 0;
+                }
+            }
+            // degenerate eigenvalues form one level, the tolerance of SinkSpectrum
+            double spread = 1 + (n == 0 ? 0 : std::max(std::abs(lambda.front()), std::abs(lambda.back())));
+            level_begin.clear();
+            for (std::size_t k = 0; k < n; ++k) {
+                if (k == 0 || 1e-10 * spread < lambda[k] - lambda[level_begin.back()]) {
+                    level_begin.push_back(k);
+                }
+            }
+            level_begin.push_back(n);
+
+            std::vector<double> re(n), im(n), ones(n, 1), zeros(n, 0), c_re(n), c_im(n), bounds(n), averages(n);
+            for (std::size_t f = 0; f < n; ++f) {
+                std::fill(bounds.begin(), bounds.end(), 0.0);
+                std::fill(averages.begin(), averages.end(), 0.0);
+                for (std::size_t l = 0; l + 1 < level_begin.size(); ++l) {
+                    this->row_sum(f, level_begin[l], level_begin[l + 1], ones.data(), zeros.data(), re.data(), im.data());
+                    for (std::size_t s = 0; s < n; ++s) {
+                        double p = re[s] * re[s] + im[s] * im[s];
+                        bounds[s] += std::sqrt(p);
+                        averages[s] += p;
+                    }
+                }
+                for (std::size_t s = 0; s < n; ++s) {
+                    double *record = out + (f * n + s) * RECORD;
+                    record[0] = bounds[s] * bounds[s];
+                    record[1] = averages[s];
+                    record[2] = record[3] = points == 0 ? -1 : 0;
+                }
+            }
+
+            Parameters grid_params = params;
+            grid_params.points = points;
+            for (double t : time_grid(grid_params)) {
+                for (std::size_t k = 0; k < n; ++k) {
+                    c_re[k] = std::cos(lambda[k] * t);
+                    c_im[k] = -std::sin(lambda[k] * t);
+                }
+                for (std::size_t f = 0; f < n; ++f) {
+                    this->row_sum(f, 0, n, c_re.data(), c_im.data(), re.data(), im.data());
+                    for (std::size_t s = 0; s < n; ++s) {
+                        double p = re[s] * re[s] + im[s] * im[s];
+                        double *record = out + (f * n + s) * RECORD;
+                        if (record[2] < p) {
+                            record[2] = p;
+                            record[3] = t;
+                        }
+                    }
+                }
+            }
+        }
+
+        // reads the table of a graph of size cavities built by another screen
+        void attach(std::size_t size, const double *shared) {
+            n = size;
+            table = shared;
+        }
+
+        std::size_t size() const {
+            return n;
+        }
+
+        double bound(std::size_t start, std::size_t finish) const {
+            return table[(finish * n + start) * RECORD];
+        }
+
+        double average(std::size_t start, std::size_t finish) const {
+            return table[(finish * n + start) * RECORD + 1];
+        }
+
+        // bound, average, peak and peak time of the pair, the screen record of states_calculating
+        std::vector<double> record(std::size_t start, std::size_t finish) const {
+            const double *record = table + (finish * n + start) * RECORD;
+            return {record[0], record[1], record[2], record[3]};
+        }
+    };
+}
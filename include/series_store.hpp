@@ -0,0 +1,267 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+namespace conductivity {
+    // Compressed store of the series records of one run with O(1) access to any record. Layout:
+    //   StoreHeader (64 bytes), records index entries {offset, length} (16 bytes each), data section
+    // A record is the engine series record ((1 + vertices) * points doubles), every row of points values is
+    // quantised to multiples of step = 2 * tolerance, so no value is off by more than the tolerance, and
+    // cut into chunks of chunk values. A chunk holds the first value of its 0th .. (order - 1)th differences
+    // as zigzag varints, one byte w and the remaining order-th differences packed in w bits each: the sink
+    // population is smooth, its third differences fit in a few bits. Chunks restart the predictor, so a
+    // wide difference (a kink, the -1 diagonal) only widens its own chunk. A zero length entry is a record
+    // that was never written.
+    struct StoreHeader {
+        static constexpr std::uint64_t MAGIC = 0x3130305353434347ull; // "GCSS0001"
+
+        std::uint64_t magic = MAGIC;
+        std::uint64_t records = 0;
+        std::uint32_t n = 0, size = 0;
+        // records of one graph, size * size or 1 for single pair runs
+        std::uint32_t per_graph = 0;
+        std::uint32_t points = 0;
+        std::uint32_t rows = 1;
+        std::uint32_t chunk = 128;
+        std::uint32_t order = 3;
+        std::uint32_t unused = 0;
+        double step = 2e-8;
+        std::uint64_t data_bytes = 0;
+
+        std::uint64_t values() const {
+            return std::uint64_t(rows) * points;
+        }
+
+        std::uint64_t data_begin() const {
+            return sizeof(StoreHeader) + 16 * records;
+        }
+    };
+    static_assert(sizeof(StoreHeader) == 64);
+
+    struct StoreEntry {
+        std::uint64_t offset = 0;
+        std::uint64_t length = 0;
+    };
+    static_assert(sizeof(StoreEntry) == 16);
+
+    class SeriesCodec {
+    private:
+        StoreHeader header;
+
+        static std::uint64_t zigzag(std::int64_t x) {
+            return (std::uint64_t(x) << 1) ^ std::uint64_t(x >> 63);
+        }
+
+        static std::int64_t unzigzag(std::uint64_t x) {
+            return std::int64_t(x >> 1) ^ -std::int64_t(x & 1);
+        }
+
+        static void put_varint(std::uint64_t x, std::vector<unsigned char>& out) {
+            while (0x80 <= x) {
+                out.push_back((unsigned char) (x | 0x80));
+                x >>= 7;
+            }
+            out.push_back((unsigned char) x);
+        }
+
+        static std::uint64_t get_varint(const unsigned char*& in, const unsigned char* end) {
+            std::uint64_t x = 0;
+            for (int shift = 0; in < end && shift < 64; shift += 7) {
+                unsigned char byte = *in++;
+                x |= std::uint64_t(byte & 0x7f) << shift;
+                if (!(byte & 0x80)) {
+                    return x;
+                }
+            }
+            throw "Error - series store: truncated record";
+        }
+
+        void encode_chunk(const std::int64_t* q, std::size_t count, std::vector<unsigned char>& out) const {
+            std::size_t order = std::min<std::size_t>(header.order, count);
+            std::vector<std::int64_t> d(q, q + count);
+            for (std::size_t k = 0; k < order; ++k) {
+                put_varint(zigzag(d[k]), out);
+                // differences in place, d[k + 1 ..] becomes the (k + 1)th difference
+                for (std::size_t j = count - 1; k < j; --j) {
+                    d[j] -= d[j - 1];
+                }
+            }
+            if (count == order) {
+                return;
+            }
+            std::uint64_t widest = 0;
+            for (std::size_t j = order; j < count; ++j) {
+                widest |= zigzag(d[j]);
+            }
+            unsigned w = 64 - std::countl_zero(widest);
+            out.push_back((unsigned char) w);
+            unsigned __int128 bits = 0;
+            unsigned filled = 0;
+            for (std::size_t j = order; j < count; ++j) {
+                bits |= (unsigned __int128) zigzag(d[j]) << filled;
+                filled += w;
+                while (8 <= filled) {
+                    out.push_back((unsigned char) bits);
+                    bits >>= 8;
+                    filled -= 8;
+                }
+            }
+            if (filled) {
+                out.push_back((unsigned char) bits);
+            }
+        }
+
+        void decode_chunk(const unsigned char*& in, const unsigned char* end, std::int64_t* q, std::size_t count) const {
+            std::size_t order = std::min<std::size_t>(header.order, count);
+            std::vector<std::int64_t> first(order);
+            for (std::size_t k = 0; k < order; ++k) {
+                first[k] = unzigzag(get_varint(in, end));
+            }
+            if (order < count) {
+                if (in == end) {
+                    throw "Error - series store: truncated record";
+                }
+                unsigned w = *in++;
+                std::uint64_t mask = w == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << w) - 1;
+                unsigned __int128 bits = 0;
+                unsigned filled = 0;
+                for (std::size_t j = order; j < count; ++j) {
+                    while (filled < w) {
+                        if (in == end) {
+                            throw "Error - series store: truncated record";
+                        }
+                        bits |= (unsigned __int128) *in++ << filled;
+                        filled += 8;
+                    }
+                    q[j] = unzigzag(std::uint64_t(bits) & mask);
+                    bits >>= w;
+                    filled -= w;
+                }
+            }
+            // prefix sums from the highest difference down, level k starts with first[k]
+            for (std::size_t k = order; k-- > 0;) {
+                q[k] = first[k];
+                for (std::size_t j = k + 1; j < count; ++j) {
+                    q[j] += q[j - 1];
+                }
+            }
+        }
+
+    public:
+        SeriesCodec(const StoreHeader& header) : header(header) {
+            if (header.points == 0 || header.chunk == 0 || header.order == 0 || 4 < header.order || !(0 < header.step)) {
+                throw "Error - series store: incorrect codec parameters";
+            }
+        }
+
+        // appends the encoding of one record of header.values() values
+        void encode(const std::vector<double>& values, std::vector<unsigned char>& out) const {
+            if (values.size() != header.values()) {
+                throw "Error - series store: incorrect record length";
+            }
+            std::vector<std::int64_t> q(values.size());
+            for (std::size_t j = 0; j < values.size(); ++j) {
+                // the 4th difference of such values still fits in 63 bits
+                double scaled = std::nearbyint(values[j] / header.step);
+                if (!(std::abs(scaled) < 0x1p58)) {
+                    throw "Error - series store: value out of the quantisation range";
+                }
+                q[j] = std::int64_t(scaled);
+            }
+            for (std::size_t row = 0; row < header.rows; ++row) {
+                for (std::size_t j = 0; j < header.points; j += header.chunk) {
+                    std::size_t count = std::min<std::size_t>(header.chunk, header.points - j);
+                    encode_chunk(q.data() + row * header.points + j, count, out);
+                }
+            }
+        }
+
+        void decode(const unsigned char* in, std::size_t length, std::vector<double>& values) const {
+            const unsigned char* end = in + length;
+            std::vector<std::int64_t> q(header.values());
+            for (std::size_t row = 0; row < header.rows; ++row) {
+                for (std::size_t j = 0; j < header.points; j += header.chunk) {
+                    std::size_t count = std::min<std::size_t>(header.chunk, header.points - j);
+                    decode_chunk(in, end, q.data() + row * header.points + j, count);
+                }
+            }
+            values.resize(q.size());
+            for (std::size_t j = 0; j < q.size(); ++j) {
+                values[j] = double(q[j]) * header.step;
+            }
+        }
+    };
+
+    // Random access reader of a store: one seek for the index entry and one read of the record.
+    class SeriesStore {
+    private:
+        std::ifstream in;
+        StoreHeader h;
+        SeriesCodec codec;
+        std::vector<unsigned char> buffer;
+
+        static StoreHeader read_header(std::ifstream& in, const std::string& path) {
+            in.open(path, std::ios::binary);
+            StoreHeader header;
+            if (!in || !in.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != StoreHeader::MAGIC) {
+                throw "Error - series store: not a series store";
+            }
+            return header;
+        }
+
+    public:
+        explicit SeriesStore(const std::string& path) : h(read_header(in, path)), codec(h) {}
+
+        const StoreHeader& header() const {
+            return h;
+        }
+
+        // record index of the pair start, finish of graph in an all pairs store
+        std::uint64_t index(std::size_t graph, std::size_t start, std::size_t finish) const {
+            if (h.n <= graph || h.per_graph == 1 || h.size <= start || h.size <= finish) {
+                throw "Error - series store: incorrect pair";
+            }
+            return (std::uint64_t(graph) * h.size + start) * h.size + finish;
+        }
+
+        StoreEntry entry(std::uint64_t index) {
+            if (h.records <= index) {
+                throw "Error - series store: incorrect record index";
+            }
+            StoreEntry e;
+            in.seekg(sizeof(StoreHeader) + 16 * index);
+            if (!in.read(reinterpret_cast<char*>(&e), sizeof(e))) {
+                throw "Error - series store: truncated index";
+            }
+            return e;
+        }
+
+        // false if the record was never written
+        bool read(std::uint64_t index, std::vector<double>& values) {
+            StoreEntry e = this->entry(index);
+            if (e.length == 0) {
+                values.clear();
+                return false;
+            }
+            buffer.resize(e.length);
+            in.seekg(h.data_begin() + e.offset);
+            if (!in.read(reinterpret_cast<char*>(buffer.data()), e.length)) {
+                throw "Error - series store: truncated data";
+            }
+            codec.decode(buffer.data(), buffer.size(), values);
+            return true;
+        }
+
+        bool read(std::size_t graph, std::size_t start, std::size_t finish, std::vector<double>& values) {
+            return this->read(this->index(graph, start, finish), values);
+        }
+    };
+}
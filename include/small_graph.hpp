@@ -0,0 +1,352 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <type_traits>
+
+#include "graph.hpp"
+
+
+namespace graph {
+    // Graph<size> for enumeration of small graphs (size <= 11): the whole adjacency matrix lives in one
+    // machine word, uint64_t up to 8 vertices and unsigned __int128 up to 11, row v in bits
+    // [v * size, (v + 1) * size). Copies, edge toggles and comparisons are single word operations,
+    // neighbourhoods are a shift and a mask, degrees are popcounts and connectivity is a breadth-first
+    // search over neighbourhood masks, so nothing is allocated per candidate graph.
+    template<std::size_t size>
+    class SmallGraph {
+        static_assert(0 < size && size <= 11, "SmallGraph holds at most 11 vertices");
+
+    public:
+        using word = std::conditional_t<size * size <= 64, std::uint64_t, unsigned __int128>;
+        using row_mask = std::uint32_t;
+
+    private:
+        static constexpr row_mask ALL = (row_mask(1) << size) - 1;
+
+        word bits;
+
+        static int popcount(word w) {
+            if constexpr (sizeof(word) == sizeof(std::uint64_t)) {
+                return std::popcount(w);
+            } else {
+                return std::popcount(std::uint64_t(w)) + std::popcount(std::uint64_t(w >> 64));
+            }
+        }
+
+        // the same value as Graph<size>::get_hash, sons are summed in increasing order of their hashes
+        long double _get_hash(std::size_t current, std::size_t parent) const {
+            std::array<long double, size> sons_hash;
+            std::size_t sons = 0;
+            for (row_mask rest = this->row(current); rest; rest &= rest - 1) {
+                std::size_t u = std::countr_zero(rest);
+                if (u == parent) {
+                    continue;
+                }
+                // insertion keeps the at most size - 1 hashes sorted
+                long double hash = _get_hash(u, current);
+                std::size_t i = sons++;
+                for (; i != 0 && hash < sons_hash[i - 1]; --i) {
+                    sons_hash[i] = sons_hash[i - 1];
+                }
+                sons_hash[i] = hash;
+            }
+            long double current_hash = HASH_BASE;
+            for (std::size_t i = 0; i < sons; ++i) {
+                current_hash += std::log(sons_hash[i]);
+            }
+            return current_hash;
+        }
+
+    public:
+        SmallGraph() : bits(0) {}
+
+        explicit SmallGraph(word bits) : bits(bits) {}
+
+        explicit SmallGraph(const Graph<size>& graph) : bits(0) {
+            for (std::size_t i = 0; i < size; ++i) {
+                for (std::size_t j = 0; j < size; ++j) {
+                    if (graph(i, j)) {
+                        bits |= word(1) << (i * size + j);
+                    }
+                }
+            }
+        }
+
+        // both bits of the undirected edge x - y
+        static constexpr word edge_bits(std::size_t x, std::size_t y) {
+            return (word(1) << (x * size + y)) | (word(1) << (y * size + x));
+        }
+
+        word data() const {
+            return bits;
+        }
+
+        row_mask row(std::size_t x) const {
+            return row_mask(bits >> (x * size)) & ALL;
+        }
+
+        bool operator()(std::size_t x, std::size_t y) const {
+            if (size <= x || size <= y) {
+                throw "Error - graph subscriptor: incorect index value";
+            }
+            return (this->row(x) >> y) & 1;
+        }
+
+        bool operator==(const SmallGraph<size>& other) const {
+            return bits == other.bits;
+        }
+
+        bool operator!=(const SmallGraph<size>& other) const {
+            return bits != other.bits;
+        }
+
+        void toggle(std::size_t x, std::size_t y) {
+            bits ^= edge_bits(x, y);
+        }
+
+        SmallGraph<size>& operator+=(const Edge& edge) {
+            if (size <= edge[0] || size <= edge[1]) {
+                throw "Error - graph += edge operator: incorrect edge";
+            }
+            bits |= edge_bits(edge[0], edge[1]);
+            return *this;
+        }
+
+        SmallGraph<size>& operator-=(const Edge& edge) {
+            if (size <= edge[0] || size <= edge[1]) {
+                throw "Error - graph -= edge operator: incorrect edge";
+            }
+            bits &= ~edge_bits(edge[0], edge[1]);
+            return *this;
+        }
+
+        SmallGraph<size> operator+(const Edge& edge) const {
+            SmallGraph<size> new_graph(*this);
+            return new_graph += edge;
+        }
+
+        SmallGraph<size> operator-(const Edge& edge) const {
+            SmallGraph<size> new_graph(*this);
+            return new_graph -= edge;
+        }
+
+        std::size_t degree(std::size_t x) const {
+            return std::popcount(this->row(x));
+        }
+
+        std::size_t edges_count() const {
+            return popcount(bits) / 2;
+        }
+
+        // degrees in non-increasing order
+        std::array<std::uint8_t, size> degree_sequence() const {
+            std::array<std::uint8_t, size> result;
+            for (std::size_t v = 0; v < size; ++v) {
+                result[v] = std::uint8_t(this->degree(v));
+            }
+            std::sort(result.begin(), result.end(), [](std::uint8_t a, std::uint8_t b) {
+                return b < a;
+            });
+            return result;
+        }
+
+        bool connected() const {
+            row_mask reached = 1, frontier = 1;
+            while (frontier) {
+                row_mask next = 0;
+                for (; frontier; frontier &= frontier - 1) {
+                    next |= this->row(std::countr_zero(frontier));
+                }
+                frontier = next & ~reached;
+                reached |= next;
+            }
+            return reached == ALL;
+        }
+
+        bool operator~() const {
+            return this->connected();
+        }
+
+        long double get_hash(std::size_t root) const {
+            return _get_hash(root, root);
+        }
+
+        // rooted tree hash comparison of Graph<size>::operator%
+        bool operator%(const SmallGraph<size>& other) const {
+            long double self_hash = this->get_hash(0);
+            for (std::size_t other_root = 0; other_root < size; ++other_root) {
+                if (self_hash == other.get_hash(other_root)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        Graph<size> to_graph() const {
+            Graph<size> graph;
+            for (std::size_t i = 0; i < size; ++i) {
+                for (std::size_t j = 0; j < size; ++j) {
+                    if ((*this)(i, j)) {
+                        graph += Edge(i, j);
+                    }
+                }
+            }
+            return graph;
+        }
+    };
+
+    template<std::size_t size>
+    std::ostream& operator<<(std::ostream& os, const SmallGraph<size>& graph) {
+        os << size << std::endl;
+        for (std::size_t i = 0; i < size; ++i) {
+            for (std::size_t j = 0; j < size; ++j) {
+                os << (graph(i, j) ? '1' : '0');
+            }
+            os << std::endl;
+        }
+        return os;
+    }
+
+    // Connectivity of a SmallGraph changed one edge at a time, without searching the graph on every step.
+    // A spanning forest is kept as row masks with the components it spans, each under a label taken from a
+    // pool of free ones: two joined components keep the label of the larger, the smaller side of a split
+    // takes a free label. An added edge between two components joins them and enters the forest, any other
+    // added edge and any removed edge outside the forest change nothing. A removed forest edge cuts its tree in two,
+    // the side of one end is grown over forest rows and the first graph edge leaving it replaces the
+    // removed one; only when there is none does the component split. Connectivity is then one comparison.
+    template<std::size_t size>
+    class Connectivity {
+    private:
+        using row_mask = typename SmallGraph<size>::row_mask;
+
+        std::array<row_mask, size> forest;
+        // label of every vertex, vertices of every label and the labels of no component
+        std::array<std::uint8_t, size> label, unused;
+        std::array<row_mask, size> members;
+        std::size_t components = size, edges = 0;
+
+        // the smaller of the two trees of the forest holding u and v, grown a level each in turn
+        row_mask smaller_tree(std::size_t u, std::size_t v) const {
+            std::array<row_mask, 2> reached = {row_mask(1) << u, row_mask(1) << v}, frontier = reached;
+            for (std::size_t side = 0;; side ^= 1) {
+                row_mask next = 0;
+                for (row_mask rest = frontier[side]; rest; rest &= rest - 1) {
+                    next |= forest[std::countr_zero(rest)];
+                }
+                frontier[side] = next & ~reached[side];
+                reached[side] |= next;
+                if (!frontier[side]) {
+                    return reached[side];
+                }
+            }
+        }
+
+        // vertices move to the component of label id
+        void relabel(row_mask vertices, std::size_t id) {
+            members[id] |= vertices;
+            for (; vertices; vertices &= vertices - 1) {
+                label[std::countr_zero(vertices)] = std::uint8_t(id);
+            }
+        }
+
+    public:
+        Connectivity() {
+            this->reset(SmallGraph<size>());
+        }
+
+        void reset(const SmallGraph<size>& graph) {
+            components = 0;
+            edges = graph.edges_count();
+            row_mask reached = 0;
+            for (std::size_t root = 0; root < size; ++root) {
+                forest[root] = 0;
+                members[root] = 0;
+            }
+            for (std::size_t root = 0; root < size; ++root) {
+                if (reached >> root & 1) {
+                    continue;
+                }
+                // breadth-first search, every vertex enters the forest by the edge it was found by
+                row_mask tree = row_mask(1) << root, frontier = tree;
+                while (frontier) {
+                    row_mask next = 0;
+                    for (; frontier; frontier &= frontier - 1) {
+                        std::size_t v = std::countr_zero(frontier);
+                        for (row_mask found = graph.row(v) & ~tree & ~next; found; found &= found - 1) {
+                            std::size_t u = std::countr_zero(found);
+                            forest[v] |= row_mask(1) << u;
+                            forest[u] |= row_mask(1) << v;
+                        }
+                        next |= graph.row(v) & ~tree;
+                    }
+                    frontier = next;
+                    tree |= next;
+                }
+                reached |= tree;
+                this->relabel(tree, components++);
+            }
+            for (std::size_t id = components; id < size; ++id) {
+                unused[size - 1 - id] = std::uint8_t(id);
+            }
+        }
+
+        // after the edge u, v was added
+        void inserted(std::size_t u, std::size_t v) {
+            ++edges;
+            std::size_t a = label[u], b = label[v];
+            if (a == b) {
+                return;
+            }
+            forest[u] |= row_mask(1) << v;
+            forest[v] |= row_mask(1) << u;
+            // the smaller component takes the label of the larger one
+            if (std::popcount(members[a]) < std::popcount(members[b])) {
+                std::swap(a, b);
+            }
+            this->relabel(members[b], a);
+            members[b] = 0;
+            unused[size - components] = std::uint8_t(b);
+            --components;
+        }
+
+        // after the edge u, v was removed from graph
+        void erased(const SmallGraph<size>& graph, std::size_t u, std::size_t v) {
+            --edges;
+            if (!(forest[u] >> v & 1)) {
+                return;
+            }
+            forest[u] &= ~(row_mask(1) << v);
+            forest[v] &= ~(row_mask(1) << u);
+            row_mask side = this->smaller_tree(u, v);
+            // the forest now has size - components - 1 edges, a replacement is one of the others
+            bool spare = size - components - 1 < edges;
+            for (row_mask rest = spare ? side : 0; rest; rest &= rest - 1) {
+                std::size_t w = std::countr_zero(rest);
+                row_mask leaving = graph.row(w) & ~side;
+                if (leaving) {
+                    std::size_t x = std::countr_zero(leaving);
+                    forest[w] |= row_mask(1) << x;
+                    forest[x] |= row_mask(1) << w;
+                    return;
+                }
+            }
+            members[label[u]] &= ~side;
+            this->relabel(side, unused[size - components - 1]);
+            ++components;
+        }
+
+        bool connected() const {
+            return components == 1;
+        }
+    };
+
+    // packed representation wherever it fits, the array one otherwise
+    template<std::size_t size>
+    using CompactGraph = std::conditional_t<(size <= 11), SmallGraph<size>, Graph<size>>;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "linalg.hpp"
+
+
+namespace linalg {
+    // compressed sparse row matrix, O(n + nnz) memory
+    class CsrMatrix {
+    private:
+        std::size_t n;
+        std::vector<std::size_t> offsets;
+        std::vector<std::size_t> columns;
+        cvector values;
+
+    public:
+        CsrMatrix() : n(0), offsets(1, 0) {}
+
+        // entries (i, j, value) in any order, repeated positions are summed
+        CsrMatrix(std::size_t n, std::vector<std::pair<std::pair<std::size_t, std::size_t>, complex>> entries) : n(n) {
+            std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+                return a.first < b.first;
+            });
+            offsets.assign(n + 1, 0);
+            for (std::size_t k = 0; k < entries.size(); ++k) {
+                auto [i, j] = entries[k].first;
+                if (n <= i || n <= j) {
+                    throw "Error - csr matrix: incorrect entry index";
+                }
+                if (!columns.empty() && k != 0 && entries[k - 1].first == entries[k].first) {
+                    values.back() += entries[k].second;
+                    continue;
+                }
+                columns.push_back(j);
+                values.push_back(entries[k].second);
+                ++offsets[i + 1];
+            }
+            for (std::size_t i = 0; i < n; ++i) {
+                offsets[i + 1] += offsets[i];
+            }
+        }
+
+        std::size_t dim() const {
+            return n;
+        }
+
+        std::size_t nnz() const {
+            return columns.size();
+        }
+
+        // entries of row i are row_begin(i) <= idx < row_end(i)
+        std::size_t row_begin(std::size_t i) const {
+            return offsets[i];
+        }
+
+        std::size_t row_end(std::size_t i) const {
+            return offsets[i + 1];
+        }
+
+        std::size_t column(std::size_t idx) const {
+            return columns[idx];
+        }
+
+        const complex& value(std::size_t idx) const {
+            return values[idx];
+        }
+
+        void apply(const cvector& in, cvector& out) const {
+            out.resize(n);
+            for (std::size_t i = 0; i < n; ++i) {
+                complex s = 0;
+                for (std::size_t k = offsets[i]; k < offsets[i + 1]; ++k) {
+                    s += values[k] * in[columns[k]];
+                }
+                out[i] = s;
+            }
+        }
+
+        // 1-norm bound used to choose Krylov steps
+        double norm1() const {
+            std::vector<double> col(n, 0);
+            for (std::size_t k = 0; k < columns.size(); ++k) {
+                col[columns[k]] += std::abs(values[k]);
+            }
+            return n == 0 ? 0 : *std::max_element(col.begin(), col.end());
+        }
+    };
+}
@@ -0,0 +1,541 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "conductivity.hpp"
+#include "graph.hpp"
+#include "linalg.hpp"
+
+
+namespace linalg {
+    // eigen-decomposition of a + sigma u u^H from a = V diag(values) V^H (values ascending), updated in place
+    // (Bunch, Nielsen and Sorensen, 1978): O(n^2) for the spectrum and O(n^3) for the rotated vectors.
+    // Negligible components of V^H u and repeated eigenvalues are deflated, the roots of the secular equation
+    // are bisected relative to the closer pole and the vectors are built from the recomputed Loewner z
+    // (Gu and Eisenstat, 1994), so they stay orthonormal to working precision
+    inline void hermitian_rank_one_update(std::vector<double>& values, Matrix& vectors, double sigma, const cvector& u) {
+        std::size_t n = values.size();
+        if (sigma == 0 || n == 0) {
+            return;
+        }
+        // a + sigma u u^H = -(-a - sigma u u^H), so sigma < 0 is the positive update of -a
+        if (sigma < 0) {
+            for (auto &x : values) {
+                x = -x;
+            }
+            std::reverse(values.begin(), values.end());
+            Matrix reversed(n, n);
+            for (std::size_t i = 0; i < n; ++i) {
+                for (std::size_t j = 0; j < n; ++j) {
+                    reversed(i, j) = vectors(i, n - 1 - j);
+                }
+            }
+            vectors = reversed;
+            hermitian_rank_one_update(values, vectors, -sigma, u);
+            for (auto &x : values) {
+                x = -x;
+            }
+            std::reverse(values.begin(), values.end());
+            for (std::size_t i = 0; i < n; ++i) {
+                for (std::size_t j = 0; j < n; ++j) {
+                    reversed(i, j) = vectors(i, n - 1 - j);
+                }
+            }
+            vectors = reversed;
+            return;
+        }
+
+        cvector z(n, 0);
+        for (std::size_t i = 0; i < n; ++i) {
+            for (std::size_t k = 0; k < n; ++k) {
+                z[k] += std::conj(vectors(i, k)) * u[i];
+            }
+        }
+        double spread = std::max(std::abs(values.front()), std::abs(values.back())) + sigma * std::pow(norm(z), 2);
+        double same = 1e-13 * (1 + spread);
+
+        // a repeated eigenvalue keeps one vector coupled to u, the rotated rest is deflated
+        for (std::size_t k = 0; k < n; ++k) {
+            for (std::size_t j = k + 1; j < n && values[j] - values[k] <= same; ++j) {
+                double r = std::sqrt(std::norm(z[k]) + std::norm(z[j]));
+                if (std::abs(z[j]) == 0 || r == 0) {
+                    continue;
+                }
+                complex a = z[k] / r, b = z[j] / r;
+                for (std::size_t i = 0; i < n; ++i) {
+                    complex vk = vectors(i, k), vj = vectors(i, j);
+                    vectors(i, k) = a * vk + b * vj;
+                    vectors(i, j) = std::conj(b) * vk - std::conj(a) * vj;
+                }
+                z[k] = r;
+                z[j] = 0;
+            }
+        }
+
+        std::vector<std::size_t> active;
+        double tiny = 1e-14 * (1 + norm(z));
+        for (std::size_t k = 0; k < n; ++k) {
+            if (tiny < std::abs(z[k])) {
+                active.push_back(k);
+            }
+        }
+        std::size_t m = active.size();
+        if (m == 0) {
+            return;
+        }
+        std::vector<double> d(m), w(m);
+        double total = 0;
+        for (std::size_t i = 0; i < m; ++i) {
+            d[i] = values[active[i]];
+            w[i] = std::norm(z[active[i]]);
+            total += w[i];
+        }
+
+        // root j lies in (d_j, d_(j+1)), the last one in (d_(m-1), d_(m-1) + sigma |z|^2]; it is kept as
+        // d_origin + tau so that the differences to the closer pole are exact
+        std::vector<std::size_t> origin(m);
+        std::vector<double> tau(m);
+        auto secular = [&](std::size_t o, double t) {
+            double f = 1;
+            for (std::size_t i = 0; i < m; ++i) {
+                f += sigma * w[i] / ((d[i] - d[o]) - t);
+            }
+            return f;
+        };
+        for (std::size_t j = 0; j < m; ++j) {
+            double lo, hi;
+            if (j + 1 < m) {
+                double gap = d[j + 1] - d[j];
+                if (0 <= secular(j, gap / 2)) {
+                    origin[j] = j;
+                    lo = 0;
+                    hi = gap / 2;
+                } else {
+                    origin[j] = j + 1;
+                    lo = -gap / 2;
+                    hi = 0;
+                }
+            } else {
+                origin[j] = j;
+                lo = 0;
+                hi = sigma * total;
+            }
+            for (int iteration = 0; iteration < 200; ++iteration) {
+                double mid = lo + (hi - lo) / 2;
+                if (mid <= lo || hi <= mid) {
+                    break;
+                }
+                (secular(origin[j], mid) < 0 ? lo : hi) = mid;
+            }
+            tau[j] = lo + (hi - lo) / 2;
+        }
+
+        auto gap = [&](std::size_t i, std::size_t j) {
+            // d_i - mu_j
+            return (d[i] - d[origin[j]]) - tau[j];
+        };
+        // z with the computed roots as its exact eigenvalues
+        std::vector<double> zz(m);
+        for (std::size_t i = 0; i < m; ++i) {
+            double s = -gap(i, m - 1) / sigma;
+            for (std::size_t j = 0; j < i; ++j) {
+                s *= gap(i, j) / (d[i] - d[j]);
+            }
+            for (std::size_t j = i; j + 1 < m; ++j) {
+                s *= gap(i, j) / (d[i] - d[j + 1]);
+            }
+            zz[i] = std::sqrt(std::max(s, 0.0));
+        }
+
+        Matrix mix(m, m);
+        for (std::size_t j = 0; j < m; ++j) {
+            double length = 0;
+            for (std::size_t i = 0; i < m; ++i) {
+                complex x = zz[i] * (z[active[i]] / std::abs(z[active[i]])) / gap(i, j);
+                mix(i, j) = x;
+                length += std::norm(x);
+            }
+            length = std::sqrt(length);
+            for (std::size_t i = 0; i < m; ++i) {
+                mix(i, j) /= length;
+            }
+        }
+        cvector row(m);
+        for (std::size_t r = 0; r < n; ++r) {
+            std::fill(row.begin(), row.end(), complex(0));
+            for (std::size_t i = 0; i < m; ++i) {
+                complex x = vectors(r, active[i]);
+                for (std::size_t j = 0; j < m; ++j) {
+                    row[j] += x * mix(i, j);
+                }
+            }
+            for (std::size_t j = 0; j < m; ++j) {
+                vectors(r, active[j]) = row[j];
+            }
+        }
+        for (std::size_t j = 0; j < m; ++j) {
+            values[active[j]] = d[origin[j]] + tau[j];
+        }
+
+        // the new values interlace with the deflated ones, restore ascending order
+        std::vector<std::size_t> order(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t x, std::size_t y) {
+            return values[x] < values[y];
+        });
+        std::vector<double> sorted_values(n);
+        Matrix sorted(n, n);
+        for (std::size_t j = 0; j < n; ++j) {
+            sorted_values[j] = values[order[j]];
+            for (std::size_t i = 0; i < n; ++i) {
+                sorted(i, j) = vectors(i, order[j]);
+            }
+        }
+        values = sorted_values;
+        vectors = sorted;
+    }
+}
+
+
+namespace conductivity {
+    using linalg::complex;
+    using linalg::cvector;
+
+    // Sink population of one pair from the spectrum of the waveguide matrix A (coupling 1). In the eigenbasis
+    // of A a parameter point g A - i leak / 2 |finish><finish| is diagonal plus a rank-one term, so its
+    // spectrum is the set of roots of the secular equation 1 + rho sum_l w_l / (g lambda_l - mu) = 0,
+    // rho = -i leak / 2, w_l the weight of the finish cavity in level l; they are found together by
+    // Aberth iteration in O(r^2). The finish amplitude is then s(t) = sum_k b_k exp(-i mu_k t) and the sink
+    // population leak int_0^t |s|^2 is integrated by Gauss-Legendre in O(r) per grid point.
+    class SinkSpectrum {
+    private:
+        // distinct levels seen by the finish cavity, their finish weights and overlaps with start
+        std::vector<double> levels, weights;
+        linalg::cvector overlaps;
+
+    public:
+        SinkSpectrum() {}
+
+        // from the eigenvalues (ascending) and eigenvectors (columns) of the waveguide matrix in some orthonormal
+        // coordinates, sink and initial are the finish and start cavities in the same coordinates; degenerate
+        // levels are merged, only their component along the finish cavity is coupled
+        SinkSpectrum(const std::vector<double>& lambda, const linalg::Matrix& v,
+                     const linalg::cvector& sink, const linalg::cvector& initial) {
+            double spread = 1 + (lambda.empty() ? 0 : std::max(std::abs(lambda.front()), std::abs(lambda.back())));
+            for (std::size_t l = 0; l < lambda.size(); ++l) {
+                complex vs = 0, vi = 0;
+                for (std::size_t i = 0; i < sink.size(); ++i) {
+                    vs += std::conj(v(i, l)) * sink[i];
+                    vi += std::conj(v(i, l)) * initial[i];
+                }
+                if (levels.empty() || 1e-10 * spread < lambda[l] - levels.back()) {
+                    levels.push_back(lambda[l]);
+                    weights.push_back(0);
+                    overlaps.push_back(0);
+                }
+                weights.back() += std::norm(vs);
+                overlaps.back() += std::conj(vs) * vi;
+            }
+            std::size_t kept = 0;
+            for (std::size_t l = 0; l < levels.size(); ++l) {
+                if (1e-14 < weights[l]) {
+                    levels[kept] = levels[l];
+                    weights[kept] = weights[l];
+                    overlaps[kept] = overlaps[l];
+                    ++kept;
+                }
+            }
+            levels.resize(kept);
+            weights.resize(kept);
+            overlaps.resize(kept);
+        }
+
+        // false if the expansion is ill-conditioned (near an exceptional point of g A - i leak / 2 P_finish),
+        // the caller should then evolve the pair directly
+        bool sink_population(const Parameters& params, std::vector<double>& result) const {
+            static const double nodes[5] = {-0.9061798459386640, -0.5384693101056831, 0.0, 0.5384693101056831, 0.9061798459386640};
+            static const double node_weights[5] = {0.2369268850561891, 0.4786286704993665, 0.5688888888888889, 0.4786286704993665, 0.2369268850561891};
+
+            std::size_t m = levels.size();
+            double c = params.leak / 2;
+            complex rho(0, -c);
+            result.assign(params.points, 0);
+            if (m == 0 || c == 0) {
+                return true;
+            }
+            if (params.points < 2 || params.coupling == 0) {
+                return false;
+            }
+
+            // roots mu_k = g lambda_k + delta_k, kept relative to their own level for accuracy
+            std::vector<double> d(m);
+            linalg::cvector delta(m), correction(m);
+            double scale = 0;
+            for (std::size_t k = 0; k < m; ++k) {
+                d[k] = params.coupling * levels[k];
+                delta[k] = rho * weights[k];
+                scale = std::max(scale, std::abs(d[k]));
+            }
+            scale += c;
+            for (int iteration = 0;; ++iteration) {
+                if (iteration == 500) {
+                    return false;
+                }
+                double largest = 0;
+                for (std::size_t k = 0; k < m; ++k) {
+                    // N = f * prod (d_l - mu), N' / N = f' / f + sum 1 / (mu - d_l)
+                    complex f = 1, df = 0, poles = 0, others = 0;
+                    for (std::size_t l = 0; l < m; ++l) {
+                        complex gap = l == k ? -delta[k] : complex(d[l] - d[k]) - delta[k];
+                        f += rho * weights[l] / gap;
+                        df += rho * weights[l] / (gap * gap);
+                        poles -= 1.0 / gap;
+                        if (l != k) {
+                            others += 1.0 / (complex(d[k] - d[l]) + delta[k] - delta[l]);
+                        }
+                    }
+                    correction[k] = 1.0 / (df / f + poles - others);
+                    largest = std::max(largest, std::abs(correction[k]));
+                }
+                for (std::size_t k = 0; k < m; ++k) {
+                    delta[k] -= correction[k];
+                }
+                if (largest <= 1e-15 * scale) {
+                    break;
+                }
+            }
+
+            // expansion of the start state over the right eigenvectors (D - mu_k)^-1 v
+            linalg::cvector amplitude(m), mu(m);
+            double total = 0;
+            for (std::size_t k = 0; k < m; ++k) {
+                mu[k] = d[k] + delta[k];
+                complex projection = 0, norm = 0;
+                for (std::size_t l = 0; l < m; ++l) {
+                    complex gap = l == k ? -delta[k] : complex(d[l] - d[k]) - delta[k];
+                    projection += overlaps[l] / gap;
+                    norm += weights[l] / (gap * gap);
+                }
+                complex a = projection / norm;
+                amplitude[k] = -a / rho;
+                total += std::abs(amplitude[k]);
+            }
+            // reconstruction of the overlaps and conditioning of the expansion
+            double residual = 0, size = 0;
+            for (std::size_t l = 0; l < m; ++l) {
+                complex s = 0;
+                for (std::size_t k = 0; k < m; ++k) {
+                    complex gap = l == k ? -delta[k] : complex(d[l] - d[k]) - delta[k];
+                    s += -rho * amplitude[k] * weights[l] / gap;
+                }
+                residual += std::abs(s - overlaps[l]);
+                size += std::abs(overlaps[l]);
+            }
+            if (1e-10 * (size + 1e-300) < residual || 1e6 < total) {
+                return false;
+            }
+
+            auto t = time_grid(params);
+            double omega = 0;
+            for (auto &x : mu) {
+                omega = std::max(omega, 2 * std::abs(x));
+            }
+            double h = t[1] - t[0];
+            std::size_t pieces = std::max<std::size_t>(1, std::size_t(std::ceil(omega * h)));
+            double piece = h / double(pieces);
+
+            linalg::cvector advance(m), phase(m), at_node(5 * m);
+            for (std::size_t k = 0; k < m; ++k) {
+                advance[k] = std::exp(complex(0, -piece) * mu[k]);
+                for (int q = 0; q < 5; ++q) {
+                    at_node[q * m + k] = amplitude[k] * std::exp(complex(0, -piece * (1 + nodes[q]) / 2) * mu[k]);
+                }
+            }
+            double p = 0;
+            for (std::size_t j = 1; j < params.points; ++j) {
+                // phases are advanced by products and recomputed now and then against drift
+                if ((j - 1) % 64 == 0) {
+                    for (std::size_t k = 0; k < m; ++k) {
+                        phase[k] = std::exp(complex(0, -t[j - 1]) * mu[k]);
+                    }
+                }
+                for (std::size_t s = 0; s < pieces; ++s) {
+                    for (int q = 0; q < 5; ++q) {
+                        complex amp = 0;
+                        for (std::size_t k = 0; k < m; ++k) {
+                            amp += phase[k] * at_node[q * m + k];
+                        }
+                        p += 2 * c * node_weights[q] * piece / 2 * std::norm(amp);
+                    }
+                    for (std::size_t k = 0; k < m; ++k) {
+                        phase[k] *= advance[k];
+                    }
+                }
+                result[j] = p;
+            }
+            return -1e-9 <= result.back() && result.back() <= 1 + 1e-9;
+        }
+    };
+
+    // Eigen-decomposition of the waveguide matrix of a graph (coupling 1) kept current while edges are added
+    // and removed. An edge is the rank-two Hermitian term h e_i e_j^H + conj(h) e_j e_i^H
+    // = 1/2 (x + y)(x + y)^H - 1/2 (x - y)(x - y)^H with x = e_i, y = conj(h) e_j, i.e. two rank-one
+    // updates in O(n^3) with a small constant. After every change A = V diag(values) V^H and V^H V = I
+    // are probed with one vector in O(n^2), and the decomposition is recomputed from scratch only if
+    // either drifted beyond the tolerance.
+    class SpectralGraph {
+    private:
+        std::size_t n;
+        complex hop;
+        std::vector<char> adjacency;
+        std::vector<double> values;
+        linalg::Matrix vectors;
+        std::size_t updates = 0, recomputes = 0;
+
+        linalg::complex element(std::size_t i, std::size_t j) const {
+            if (!adjacency[i * n + j]) {
+                return 0;
+            }
+            return i < j ? hop : std::conj(hop);
+        }
+
+        void recompute() {
+            linalg::Matrix a(n, n);
+            for (std::size_t i = 0; i < n; ++i) {
+                for (std::size_t j = 0; j < n; ++j) {
+                    a(i, j) = element(i, j);
+                }
+            }
+            linalg::hermitian_eigen(a, values, vectors);
+            ++recomputes;
+        }
+
+        bool accurate() const {
+            cvector x(n), y(n, 0), ax(n, 0), back(n, 0);
+            for (std::size_t i = 0; i < n; ++i) {
+                x[i] = complex(std::cos(1.0 + 0.7 * i), std::sin(0.3 + 1.3 * i));
+            }
+            for (std::size_t k = 0; k < n; ++k) {
+                for (std::size_t i = 0; i < n; ++i) {
+                    y[k] += std::conj(vectors(i, k)) * x[i];
+                }
+            }
+            for (std::size_t i = 0; i < n; ++i) {
+                for (std::size_t k = 0; k < n; ++k) {
+                    ax[i] += vectors(i, k) * (values[k] * y[k]);
+                    back[i] += vectors(i, k) * y[k];
+                }
+            }
+            double residual = 0, drift = 0, spread = 1;
+            for (auto &v : values) {
+                spread = std::max(spread, std::abs(v));
+            }
+            for (std::size_t i = 0; i < n; ++i) {
+                complex exact = 0;
+                for (std::size_t j = 0; j < n; ++j) {
+                    exact += element(i, j) * x[j];
+                }
+                residual += std::norm(ax[i] - exact);
+                drift += std::norm(back[i] - x[i]);
+            }
+            double tolerance = 1e-10 * linalg::norm(x);
+            return std::sqrt(residual) <= tolerance * spread && std::sqrt(drift) <= tolerance;
+        }
+
+    public:
+        SpectralGraph(std::size_t size, const std::vector<graph::Edge>& edges, double phase)
+            : n(size), hop(std::polar(1.0, phase)), adjacency(size * size, 0) {
+            for (auto &e : edges) {
+                if (e[0] != e[1]) {
+                    adjacency[e[0] * n + e[1]] = adjacency[e[1] * n + e[0]] = 1;
+                }
+            }
+            recompute();
+        }
+
+        // from the decomposition of the same graph computed elsewhere, values ascending and vectors as columns
+        SpectralGraph(std::size_t size, const std::vector<graph::Edge>& edges, double phase,
+                      const std::vector<double>& values, const linalg::Matrix& vectors)
+            : n(size), hop(std::polar(1.0, phase)), adjacency(size * size, 0), values(values), vectors(vectors) {
+            for (auto &e : edges) {
+                if (e[0] != e[1]) {
+                    adjacency[e[0] * n + e[1]] = adjacency[e[1] * n + e[0]] = 1;
+                }
+            }
+        }
+
+        std::size_t size() const {
+            return n;
+        }
+
+        const std::vector<double>& eigenvalues() const {
+            return values;
+        }
+
+        const linalg::Matrix& eigenvectors() const {
+            return vectors;
+        }
+
+        bool has_edge(std::size_t i, std::size_t j) const {
+            return adjacency[i * n + j];
+        }
+
+        // adds the edge i - j if it is absent and removes it otherwise, true if the update was incremental
+        bool toggle(std::size_t i, std::size_t j) {
+            if (i == j) {
+                return true;
+            }
+            if (j < i) {
+                std::swap(i, j);
+            }
+            double sign = has_edge(i, j) ? -1 : 1;
+            adjacency[i * n + j] = adjacency[j * n + i] = !has_edge(i, j);
+
+            cvector plus(n, 0), minus(n, 0);
+            plus[i] = minus[i] = 1;
+            plus[j] = std::conj(hop);
+            minus[j] = -std::conj(hop);
+            linalg::hermitian_rank_one_update(values, vectors, sign / 2, plus);
+            linalg::hermitian_rank_one_update(values, vectors, -sign / 2, minus);
+            ++updates;
+            if (!accurate()) {
+                recompute();
+                return false;
+            }
+            return true;
+        }
+
+        void add_edge(std::size_t i, std::size_t j) {
+            if (!has_edge(i, j)) {
+                toggle(i, j);
+            }
+        }
+
+        void remove_edge(std::size_t i, std::size_t j) {
+            if (has_edge(i, j)) {
+                toggle(i, j);
+            }
+        }
+
+        // incremental updates and full decompositions done so far, the construction included
+        std::size_t incremental_count() const {
+            return updates;
+        }
+
+        std::size_t recompute_count() const {
+            return recomputes;
+        }
+
+        SinkSpectrum spectrum(std::size_t start, std::size_t finish) const {
+            cvector sink(n, 0), initial(n, 0);
+            sink[finish] = 1;
+            initial[start] = 1;
+            return SinkSpectrum(values, vectors, sink, initial);
+        }
+    };
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "conductivity.hpp"
+#include "graph.hpp"
+#include "krylov.hpp"
+#include "linalg.hpp"
+#include "sparse.hpp"
+#include "spectral.hpp"
+
+
+namespace conductivity {
+    // Grid of a parameter sweep, the phase is shared by all points
+    struct SweepGrid {
+        std::vector<double> couplings;
+        std::vector<double> leaks;
+        std::vector<double> t_maxes;
+        double phase = 2 * M_PI;
+        std::size_t points = 2000;
+
+        std::size_t size() const {
+            return couplings.size() * leaks.size() * t_maxes.size();
+        }
+
+        // the point (coupling, leak, t_max) stored at index ((ic * leaks + il) * t_maxes + it)
+        Parameters at(std::size_t ic, std::size_t il, std::size_t it) const {
+            Parameters params;
+            params.coupling = couplings[ic];
+            params.leak = leaks[il];
+            params.t_max = t_maxes[it];
+            params.phase = phase;
+            params.points = points;
+            return params;
+        }
+    };
+
+    // The Hamiltonian of every sweep point is g A - i leak / 2 |finish><finish| with the same waveguide
+    // matrix A (coupling 1), so the photon never leaves the smallest A-invariant subspace containing
+    // start and finish. Its orthonormal basis Q is built once per pair by block Arnoldi from
+    // [e_start, e_finish] run to exhaustion, and T = Q^H A Q is diagonalized once; its dimension is at
+    // most the number of cavities and much lower for symmetric graphs. Every sweep point is then evolved
+    // from the spectrum of T (SinkSpectrum) in O(r^2 + r * points); points whose expansion is
+    // ill-conditioned (near exceptional points) fall back to exact stepping with exp(-i H_r dt).
+    class ReducedPair {
+    private:
+        std::size_t r;
+        linalg::Matrix waveguides;
+        linalg::cvector sink, initial;
+
+        SinkSpectrum spectrum;
+
+        void stepping(const Parameters& params, std::vector<double>& result) const {
+            auto t = time_grid(params);
+            result.assign(params.points, 0);
+            if (params.points == 0) {
+                return;
+            }
+
+            double dt = params.points < 2 ? t[0] : t[1] - t[0];
+            linalg::Matrix step(r, r);
+            for (std::size_t i = 0; i < r; ++i) {
+                for (std::size_t j = 0; j < r; ++j) {
+                    complex h = params.coupling * waveguides(i, j) - complex(0, params.leak / 2) * sink[i] * std::conj(sink[j]);
+                    step(i, j) = complex(0, -dt) * h;
+                }
+            }
+            step = linalg::expm(step);
+
+            linalg::cvector y = initial, y_next;
+            std::size_t first = params.points < 2 ? 0 : 1;
+            for (std::size_t k = first; k < params.points; ++k) {
+                step.apply(y, y_next);
+                std::swap(y, y_next);
+                double survived = linalg::norm(y);
+                result[k] = 1 - survived * survived;
+            }
+        }
+
+    public:
+        ReducedPair() : r(0) {}
+
+        // false if the invariant subspace is larger than max_dim, the pair should then be
+        // evolved point by point with the Krylov propagator
+        bool build(const linalg::CsrMatrix& a, std::size_t start, std::size_t finish, std::size_t max_dim) {
+            std::size_t n = a.dim();
+            std::vector<linalg::cvector> q, aq;
+            linalg::cvector w(n);
+
+            auto append = [&](linalg::cvector& v) {
+                double before = linalg::norm(v);
+                for (int pass = 0; pass < 2; ++pass) {
+                    for (auto &b : q) {
+                        complex c = linalg::dot(b, v);
+                        for (std::size_t i = 0; i < n; ++i) {
+                            v[i] -= c * b[i];
+                        }
+                    }
+                }
+                double after = linalg::norm(v);
+                if (after <= 1e-10 * (1 + before)) {
+                    return;
+                }
+                for (auto &x : v) {
+                    x /= after;
+                }
+                q.push_back(v);
+            };
+
+            for (std::size_t v : {start, finish}) {
+                std::fill(w.begin(), w.end(), complex(0));
+                w[v] = 1;
+                append(w);
+            }
+            for (std::size_t j = 0; j < q.size(); ++j) {
+                if (max_dim < q.size()) {
+                    return false;
+                }
+                aq.emplace_back();
+                a.apply(q[j], aq.back());
+                w = aq.back();
+                append(w);
+            }
+
+            r = q.size();
+            waveguides = linalg::Matrix(r, r);
+            sink.assign(r, 0);
+            initial.assign(r, 0);
+            for (std::size_t i = 0; i < r; ++i) {
+                for (std::size_t j = 0; j < r; ++j) {
+                    waveguides(i, j) = linalg::dot(q[i], aq[j]);
+                }
+                sink[i] = std::conj(q[i][finish]);
+                initial[i] = std::conj(q[i][start]);
+            }
+
+            std::vector<double> lambda;
+            linalg::Matrix v;
+            linalg::hermitian_eigen(waveguides, lambda, v);
+            spectrum = SinkSpectrum(lambda, v, sink, initial);
+            return true;
+        }
+
+        std::size_t dim() const {
+            return r;
+        }
+
+        std::vector<double> sink_population(const Parameters& params) const {
+            std::vector<double> result;
+            if (!spectrum.sink_population(params, result)) {
+                stepping(params, result);
+            }
+            return result;
+        }
+    };
+
+    // waveguide matrix of the sweep, the Hamiltonian with coupling 1 and no leak
+    inline linalg::CsrMatrix waveguides(std::size_t size, const std::vector<graph::Edge>& edges, double phase) {
+        Parameters params;
+        params.coupling = 1;
+        params.phase = phase;
+        params.leak = 0;
+        return hamiltonian(size, edges, 0, params);
+    }
+
+    // every point of the grid for one pair, in grid order, the reduced space is built once
+    // and up to max_dim; larger pairs fall back to the Krylov propagator on the full graph
+    inline std::vector<std::vector<double>> sweep(std::size_t size, const std::vector<graph::Edge>& edges,
+                                                  const linalg::CsrMatrix& a, std::size_t start, std::size_t finish,
+                                                  const SweepGrid& grid, std::size_t max_dim,
+                                                  linalg::KrylovPropagator& propagator) {
+        std::vector<std::vector<double>> result;
+        result.reserve(grid.size());
+        ReducedPair reduced;
+        bool exact = reduced.build(a, start, finish, max_dim);
+        for (std::size_t ic = 0; ic < grid.couplings.size(); ++ic) {
+            for (std::size_t il = 0; il < grid.leaks.size(); ++il) {
+                for (std::size_t it = 0; it < grid.t_maxes.size(); ++it) {
+                    Parameters params = grid.at(ic, il, it);
+                    if (exact) {
+                        result.push_back(reduced.sink_population(params));
+                    } else {
+                        result.push_back(conductivity::sink_population(hamiltonian(size, edges, finish, params), start, params, propagator));
+                    }
+                }
+            }
+        }
+        return result;
+    }
+}
@@ -0,0 +1,376 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "graph.hpp"
+
+
+namespace graph {
+    // The free (unrooted, unlabelled) trees of n vertices, each exactly once, by the constant amortised
+    // time algorithm of Wright, Richmond, Odlyzko and McKay: a tree is its canonical level sequence rooted
+    // at a centre, the sequences are walked in decreasing lexicographic order and those that are not the
+    // canonical one of their tree are jumped over.
+    class FreeTrees {
+    private:
+        std::size_t n;
+        // level of every vertex in preorder, the root at level 0
+        std::vector<int> layout;
+        bool started = false, done = false;
+
+        // the next rooted level sequence, changing positions from p on; p < 0 takes the last position above level 1
+        static bool next_rooted(std::vector<int>& layout, int p) {
+            if (p < 0) {
+                p = int(layout.size()) - 1;
+                while (layout[p] == 1) {
+                    --p;
+                }
+            }
+            if (p <= 0) {
+                return false;
+            }
+            int q = p - 1;
+            while (layout[q] != layout[p] - 1) {
+                --q;
+            }
+            for (std::size_t i = p; i < layout.size(); ++i) {
+                layout[i] = layout[i - p + q];
+            }
+            return true;
+        }
+
+        // height and length of the subtree of the first child of the root (left) and of the rest
+        static void split(const std::vector<int>& layout, int& left_height, std::size_t& left_size,
+                          int& rest_height, std::size_t& rest_size) {
+            std::size_t m = 2;
+            while (m < layout.size() && layout[m] != 1) {
+                ++m;
+            }
+            left_size = m - 1;
+            rest_size = layout.size() - m + 1;
+            left_height = *std::max_element(layout.begin() + 1, layout.begin() + m) - 1;
+            rest_height = m < layout.size() ? *std::max_element(layout.begin() + m, layout.end()) : 0;
+        }
+
+        // layout itself when it is canonical, else the next candidate that is
+        static bool next_free(std::vector<int>& layout) {
+            int left_height, rest_height;
+            std::size_t left_size, rest_size;
+            split(layout, left_height, left_size, rest_height, rest_size);
+            bool valid = left_height <= rest_height;
+            if (valid && left_height == rest_height) {
+                // the left subtree must not be larger than the rest rooted at the root
+                std::size_t m = left_size + 1;
+                if (rest_size < left_size) {
+                    valid = false;
+                } else if (left_size == rest_size) {
+                    std::vector<int> left(left_size), rest(rest_size, 0);
+                    for (std::size_t i = 0; i < left_size; ++i) {
+                        left[i] = layout[i + 1] - 1;
+                    }
+                    std::copy(layout.begin() + m, layout.end(), rest.begin() + 1);
+                    valid = !(rest < left);
+                }
+            }
+            if (valid) {
+                return true;
+            }
+            int p = int(left_size);
+            bool deep = 2 < layout[p];
+            if (!next_rooted(layout, p)) {
+                return false;
+            }
+            if (deep) {
+                split(layout, left_height, left_size, rest_height, rest_size);
+                for (int i = 0; i <= left_height; ++i) {
+                    layout[layout.size() - 1 - left_height + i] = i + 1;
+                }
+            }
+            return true;
+        }
+
+    public:
+        explicit FreeTrees(std::size_t n) : n(n) {}
+
+        // edges of the next tree, false after the last one
+        bool next(std::vector<Edge>& edges) {
+            if (done) {
+                return false;
+            }
+            if (n < 2) {
+                done = true;
+                edges.clear();
+                return n == 1;
+            }
+            if (!started) {
+                started = true;
+                for (std::size_t i = 0; i <= n / 2; ++i) {
+                    layout.push_back(int(i));
+                }
+                for (std::size_t i = 1; i < (n + 1) / 2; ++i) {
+                    layout.push_back(int(i));
+                }
+            } else if (!next_rooted(layout, -1)) {
+                done = true;
+                return false;
+            }
+            if (!next_free(layout)) {
+                done = true;
+                return false;
+            }
+
+            // parent of every vertex: the last vertex before it one level up
+            edges.clear();
+            std::vector<std::size_t> stack = {0};
+            for (std::size_t i = 1; i < n; ++i) {
+                while (layout[i] <= layout[stack.back()]) {
+                    stack.pop_back();
+                }
+                edges.push_back(Edge(stack.back(), i));
+                stack.push_back(i);
+            }
+            return true;
+        }
+    };
+
+
+    // Canonical code of a tree of n <= 32 vertices: rooted at its centre, a child is 1, the code of its
+    // subtree and 0, the children in decreasing order of their codes, 2 (n - 1) bits read from the most
+    // significant one (the AHU encoding). A tree with two centres takes the larger of its two codes. Two
+    // trees have the same code exactly when they are isomorphic, and the tree of a code numbers its
+    // vertices in preorder from the centre.
+    class TreeCode {
+    private:
+        // bits and their count
+        using Code = std::pair<std::uint64_t, std::size_t>;
+
+        std::vector<std::vector<std::size_t>> adjacent;
+
+        // order of codes as strings of bits
+        static bool less(const Code& a, const Code& b) {
+            std::uint64_t x = a.second == 0 ? 0 : a.first << (64 - a.second);
+            std::uint64_t y = b.second == 0 ? 0 : b.first << (64 - b.second);
+            return x < y || (x == y && a.second < b.second);
+        }
+
+        Code rooted(std::size_t v, std::size_t parent) const {
+            std::vector<Code> children;
+            for (std::size_t u : adjacent[v]) {
+                if (u != parent) {
+                    children.push_back(this->rooted(u, v));
+                }
+            }
+            std::sort(children.begin(), children.end(), [](const Code& a, const Code& b) {
+                return less(b, a);
+            });
+            Code code = {0, 0};
+            for (auto &child : children) {
+                code.first = (code.first << (child.second + 2)) | (std::uint64_t(1) << (child.second + 1)) | (child.first << 1);
+                code.second += child.second + 2;
+            }
+            return code;
+        }
+
+    public:
+        static constexpr std::size_t MAX_SIZE = 32;
+
+        static std::uint64_t encode(std::size_t n, const std::vector<Edge>& edges) {
+            if (n == 0 || MAX_SIZE < n || edges.size() != n - 1) {
+                throw "Error - tree code: not a tree of at most 32 vertices";
+            }
+            TreeCode tree;
+            tree.adjacent.resize(n);
+            for (auto &e : edges) {
+                if (n <= e[0] || n <= e[1] || e[0] == e[1]) {
+                    throw "Error - tree code: incorrect edge";
+                }
+                tree.adjacent[e[0]].push_back(e[1]);
+                tree.adjacent[e[1]].push_back(e[0]);
+            }
+
+            // centres: leaves are peeled off layer by layer until at most two vertices remain
+            std::vector<std::size_t> degree(n), layer;
+            for (std::size_t v = 0; v < n; ++v) {
+                degree[v] = tree.adjacent[v].size();
+                if (degree[v] <= 1) {
+                    layer.push_back(v);
+                }
+            }
+            std::size_t remaining = n;
+            while (2 < remaining) {
+                if (layer.empty()) {
+                    throw "Error - tree code: not a tree";
+                }
+                remaining -= layer.size();
+                std::vector<std::size_t> next;
+                for (std::size_t v : layer) {
+                    for (std::size_t u : tree.adjacent[v]) {
+                        if (--degree[u] == 1) {
+                            next.push_back(u);
+                        }
+                    }
+                }
+                layer = std::move(next);
+            }
+            if (layer.empty() || 2 < layer.size()) {
+                throw "Error - tree code: not a tree";
+            }
+
+            Code code = tree.rooted(layer[0], n);
+            if (layer.size() == 2) {
+                code = std::max(code, tree.rooted(layer[1], n));
+            }
+            // a cycle leaves a vertex out of the rooted code
+            if (code.second != 2 * (n - 1)) {
+                throw "Error - tree code: not a tree";
+            }
+            return code.first;
+        }
+
+        static std::vector<Edge> decode(std::size_t n, std::uint64_t code) {
+            std::vector<Edge> edges;
+            std::vector<std::size_t> stack = {0};
+            std::size_t next = 1;
+            for (std::size_t bit = 2 * (n - 1); 0 < bit; --bit) {
+                if (code >> (bit - 1) & 1) {
+                    edges.push_back(Edge(stack.back(), next));
+                    stack.push_back(next++);
+                } else {
+                    stack.pop_back();
+                }
+            }
+            return edges;
+        }
+    };
+
+
+    // Catalog of every free tree of 1 .. max_size vertices, the trees of one size sorted by their TreeCode.
+    // Layout:
+    //   CatalogHeader (280 bytes), for every size the codes of its trees (8 bytes each)
+    // A tree is unranked by reading its code at a fixed offset, O(1), and ranked by a binary search for its
+    // code, O(log N) reads; a range of trees is one contiguous read. The order depends on the codes only,
+    // so an index names the same tree in every catalog that holds its size.
+    struct CatalogHeader {
+        static constexpr std::uint64_t MAGIC = 0x3130305443544347ull; // "GCTCT001"
+
+        std::uint64_t magic = MAGIC;
+        std::uint64_t max_size = 0;
+        // trees of every size, counts[0] = 0
+        std::uint64_t counts[TreeCode::MAX_SIZE + 1] = {};
+
+        std::uint64_t offset(std::size_t size) const {
+            std::uint64_t before = 0;
+            for (std::size_t s = 1; s < size; ++s) {
+                before += counts[s];
+            }
+            return sizeof(CatalogHeader) + 8 * before;
+        }
+    };
+    static_assert(sizeof(CatalogHeader) == 8 * (TreeCode::MAX_SIZE + 3));
+
+    class TreeCatalog {
+    private:
+        std::ifstream in;
+        CatalogHeader h;
+
+        static CatalogHeader read_header(std::ifstream& in, const std::string& path) {
+            in.open(path, std::ios::binary);
+            CatalogHeader header;
+            if (!in || !in.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != CatalogHeader::MAGIC ||
+                TreeCode::MAX_SIZE < header.max_size) {
+                throw "Error - tree catalog: not a tree catalog";
+            }
+            return header;
+        }
+
+    public:
+        explicit TreeCatalog(const std::string& path) : h(read_header(in, path)) {}
+
+        // writes the catalog of the trees of 1 .. max_size vertices; the codes of one size are sorted in
+        // memory, 8 bytes per tree (300 MB for the 39 million trees of 24 vertices), which bounds max_size
+        // well below the 32 vertices a code can hold
+        static void build(const std::string& path, std::size_t max_size) {
+            if (max_size == 0 || TreeCode::MAX_SIZE < max_size) {
+                throw "Error - tree catalog: incorrect size";
+            }
+            std::ofstream out(path, std::ios::binary);
+            CatalogHeader header;
+            header.max_size = max_size;
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+            std::vector<std::uint64_t> codes;
+            std::vector<Edge> edges;
+            for (std::size_t size = 1; size <= max_size; ++size) {
+                codes.clear();
+                FreeTrees trees(size);
+                while (trees.next(edges)) {
+                    codes.push_back(TreeCode::encode(size, edges));
+                }
+                std::sort(codes.begin(), codes.end());
+                if (std::adjacent_find(codes.begin(), codes.end()) != codes.end()) {
+                    throw "Error - tree catalog: a tree was enumerated twice";
+                }
+                header.counts[size] = codes.size();
+                out.write(reinterpret_cast<const char*>(codes.data()), 8 * codes.size());
+            }
+            out.seekp(0);
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            if (!out) {
+                throw "Error - tree catalog: couldn't write catalog";
+            }
+        }
+
+        const CatalogHeader& header() const {
+            return h;
+        }
+
+        std::uint64_t count(std::size_t size) const {
+            return size <= h.max_size ? h.counts[size] : 0;
+        }
+
+        // codes of the trees first .. last - 1 of size vertices
+        void codes(std::size_t size, std::uint64_t first, std::uint64_t last, std::vector<std::uint64_t>& out) {
+            if (last < first || this->count(size) < last) {
+                throw "Error - tree catalog: incorrect tree index";
+            }
+            out.resize(last - first);
+            in.seekg(h.offset(size) + 8 * first);
+            if (!in.read(reinterpret_cast<char*>(out.data()), 8 * out.size())) {
+                throw "Error - tree catalog: truncated catalog";
+            }
+        }
+
+        std::uint64_t code(std::size_t size, std::uint64_t index) {
+            std::vector<std::uint64_t> out;
+            this->codes(size, index, index + 1, out);
+            return out[0];
+        }
+
+        std::vector<Edge> unrank(std::size_t size, std::uint64_t index) {
+            return TreeCode::decode(size, this->code(size, index));
+        }
+
+        // index of the tree with these edges among the trees of size vertices
+        std::uint64_t rank(std::size_t size, const std::vector<Edge>& edges) {
+            std::uint64_t code = TreeCode::encode(size, edges);
+            std::uint64_t low = 0, high = this->count(size);
+            while (low < high) {
+                std::uint64_t middle = low + (high - low) / 2;
+                if (this->code(size, middle) < code) {
+                    low = middle + 1;
+                } else {
+                    high = middle;
+                }
+            }
+            if (low == this->count(size) || this->code(size, low) != code) {
+                throw "Error - tree catalog: tree is not in the catalog";
+            }
+            return low;
+        }
+    };
+}
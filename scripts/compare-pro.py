@@ -8,6 +8,14 @@ import math
 # --- Функции read_matrices_from_file и create_value_counts ---
 # (Без изменений, как в предыдущем ответе)
 def read_matrices_from_file(filename):
+    # .npy формы (n, size, size) от states_calculating --final ... --npy отображается в память без разбора
+    if filename.endswith('.npy'):
+        try:
+            data = np.load(filename, mmap_mode='r')
+            if data.ndim != 3 or data.shape[1] != data.shape[2]: raise ValueError(f"Ожидалась форма (n, size, size), получена {data.shape}.")
+            return list(data)
+        except FileNotFoundError: print(f"Ошибка: Файл '{filename}' не найден."); return None
+        except ValueError as ve: print(f"Ошибка чтения: {ve}"); return None
     matrices = []
     try:
         with open(filename, 'r') as f:
@@ -1,6 +1,5 @@
 import numpy as np
 import matplotlib.pyplot as plt
-from sklearn.isotonic import IsotonicRegression
 import os
 import traceback
 
@@ -15,6 +14,10 @@ X_PLOT_MAX = 500
 OUTPUT_FILENAME_SINGLE = "plot_{filename}_all_lines_norm_tail.png" # Шаблон для одного файла
 OUTPUT_FILENAME_MULTI = "combined_plot_multi_file_norm_tail.png" # Имя для нескольких файлов
 OUTPUT_DIR = "plots_output" # Общая папка для итоговых графиков
+OBSERVED_ROWS = 0 # Для .npy с --observe: 1 + число наблюдаемых вершин; 0 - файл без оси --observe
+# Точки хвоста; строки такой длины - готовый результат postprocess_series --tail --npy
+_x = np.linspace(X_MIN, X_MAX, NUM_POINTS)
+TAIL_POINTS = int(np.count_nonzero((_x >= X_PLOT_MIN) & (_x <= X_PLOT_MAX)))
 # -----------------
 
 def read_data_file(filename):
@@ -22,6 +25,8 @@ def read_data_file(filename):
     Читает данные из файла. Ожидает NUM_POINTS float значений в каждой строке.
     Возвращает список numpy массивов (каждый массив - одна строка данных).
     """
+    if filename.endswith('.npy'):
+        return read_npy_file(filename)
     data_lines = []
     line_num = 0
     print(f"Чтение файла: {filename}...")
@@ -55,14 +60,74 @@ def read_data_file(filename):
     print(f"  Файл '{filename}' прочитан, найдено {len(data_lines)} строк данных.")
     return data_lines
 
+def read_npy_file(filename):
+    """
+    Читает .npy файл (states_calculating --npy) без разбора текста: массив отображается в память,
+    строки - представления без копирования. Строки диагонали (start == finish, заполнены -1) пропускаются.
+    """
+    print(f"Чтение файла: {filename}...")
+    try:
+        data = np.load(filename, mmap_mode='r')
+    except FileNotFoundError:
+        print(f"Ошибка: Файл '{filename}' не найден.")
+        return None
+    except ValueError as e:
+        print(f"Ошибка: Файл '{filename}' не является корректным .npy: {e}")
+        return None
+
+    # с --observe предпоследняя ось - ряды стока и наблюдаемых вершин: (n, size, size, 1 + V, P) или (n, 1 + V, P);
+    # по четности осей ее не узнать, у states_calculating_incremental --deletions (n, slots, P) та же размерность
+    if OBSERVED_ROWS:
+        if data.ndim < 3 or data.shape[-2] != OBSERVED_ROWS:
+            print(f"Ошибка: В файле '{filename}' нет оси --observe из {OBSERVED_ROWS} рядов (форма {data.shape}).")
+            return None
+        data = data[..., 0, :]
+    rows = data.reshape(-1, data.shape[-1])
+    if rows.shape[1] != NUM_POINTS and rows.shape[1] != TAIL_POINTS:
+        print(f"Ошибка: В файле '{filename}' {rows.shape[1]} точек в ряду, ожидалось {NUM_POINTS} (или {TAIL_POINTS} для хвоста).")
+        return None
+    data_lines = [row for row in rows if row[0] >= 0]
+    if not data_lines:
+        print(f"В файле '{filename}' не найдено корректных строк данных.")
+        return None
+
+    print(f"  Файл '{filename}' прочитан, найдено {len(data_lines)} строк данных.")
+    return data_lines
+
 def create_monotonic_approximation(x_values, y_values):
     """
     Создает монотонно возрастающую аппроксимацию с помощью изотонической регрессии.
+    Для больших файлов быстрее postprocess_series --tail (C++, параллельно по всем рядам).
     """
+    from sklearn.isotonic import IsotonicRegression
     iso_reg = IsotonicRegression(increasing=True, y_min=0, out_of_bounds='clip')
     y_iso = iso_reg.fit_transform(x_values, y_values)
     return y_iso
 
+def normalized_tail(x_values, y_original, name):
+    """
+    Монотонная аппроксимация, нормированная на максимум, в диапазоне X_PLOT_MIN..X_PLOT_MAX.
+    Строки из postprocess_series --tail уже нормированы и рисуются как есть. Возвращает (x, y) или None.
+    """
+    plot_indices = np.where((x_values >= X_PLOT_MIN) & (x_values <= X_PLOT_MAX))[0]
+    if len(y_original) == TAIL_POINTS and len(y_original) != len(x_values):
+        return x_values[plot_indices], y_original
+
+    y_monotonic = create_monotonic_approximation(x_values, y_original)
+
+    max_y_val = np.max(y_monotonic)
+    if max_y_val < 1e-9:
+        y_normalized = y_monotonic
+        print(f"    Предупреждение: Макс. значение в {name} близко к нулю. Нормировка не применяется.")
+    else:
+        y_normalized = y_monotonic / max_y_val
+
+    if len(plot_indices) == 0:
+        print(f"    Предупреждение: В {name} нет данных в диапазоне X от {X_PLOT_MIN} до {X_PLOT_MAX}.")
+        return None
+
+    return x_values[plot_indices], y_normalized[plot_indices]
+
 def main():
     """
     Основная функция программы.
@@ -111,23 +176,10 @@ def main():
 
             for i, y_original in enumerate(all_y_data):
                 print(f"  Обработка строки {i + 1}...")
-                y_monotonic = create_monotonic_approximation(x_values, y_original)
-
-                max_y_val = np.max(y_monotonic)
-                if max_y_val < 1e-9:
-                    y_normalized = y_monotonic
-                    print(f"    Предупреждение: Макс. значение в строке {i+1} близко к нулю. Нормировка не применяется.")
-                else:
-                    y_normalized = y_monotonic / max_y_val
-
-                plot_indices = np.where((x_values >= X_PLOT_MIN) & (x_values <= X_PLOT_MAX))[0]
-
-                if len(plot_indices) == 0:
-                    print(f"    Предупреждение: В строке {i+1} нет данных в диапазоне X от {X_PLOT_MIN} до {X_PLOT_MAX}.")
+                tail = normalized_tail(x_values, y_original, f"строке {i+1}")
+                if tail is None:
                     continue
-
-                x_plot = x_values[plot_indices]
-                y_plot = y_normalized[plot_indices]
+                x_plot, y_plot = tail
 
                 # --- Используем счетчик для легенды ---
                 graph_counter += 1
@@ -151,24 +203,10 @@ def main():
             y_original = file_data[0]
             base_filename = os.path.basename(filename) # Не используется для легенды, но полезно для сообщений
             print(f"  Обработка первой строки из файла '{filename}'...")
-
-            y_monotonic = create_monotonic_approximation(x_values, y_original)
-
-            max_y_val = np.max(y_monotonic)
-            if max_y_val < 1e-9:
-                y_normalized = y_monotonic
-                print(f"    Предупреждение: Макс. значение в '{base_filename}' близко к нулю. Нормировка не применяется.")
-            else:
-                y_normalized = y_monotonic / max_y_val
-
-            plot_indices = np.where((x_values >= X_PLOT_MIN) & (x_values <= X_PLOT_MAX))[0]
-
-            if len(plot_indices) == 0:
-                print(f"    Предупреждение: В данных из '{base_filename}' нет точек в диапазоне X от {X_PLOT_MIN} до {X_PLOT_MAX}.")
+            tail = normalized_tail(x_values, y_original, f"'{base_filename}'")
+            if tail is None:
                 continue
-
-            x_plot = x_values[plot_indices]
-            y_plot = y_normalized[plot_indices]
+            x_plot, y_plot = tail
 
             # --- Используем счетчик для легенды ---
             graph_counter += 1
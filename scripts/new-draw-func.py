@@ -8,6 +8,7 @@ from matplotlib.lines import Line2D # Для создания кастомной
 FILENAME = './test/type_default/100/graph100_res_func'  # Имя входного файла
 VALUES_PER_LINE = 8000  # Ожидаемое количество значений в каждой строке
 LINES_PER_GROUP = 30    # Количество строк (графиков), образующих одну группу
+OBSERVED_ROWS = 0       # Для .npy с --observe: 1 + число наблюдаемых вершин; 0 - файл без оси --observe
 
 # --- Настройка цветов и названий для легенды ---
 # Используем стандартную палитру tab10, она хорошо различается
@@ -24,7 +25,7 @@ if len(color_names) < len(color_values):
 
 # -------------------
 
-def plot_grouped_data(filename, values_per_line, lines_per_group):
+def plot_grouped_data(filename, values_per_line, lines_per_group, observed_rows=0):
     """
     Читает данные из файла, группирует строки и строит графики.
 
@@ -32,35 +33,56 @@ def plot_grouped_data(filename, values_per_line, lines_per_group):
         filename (str): Путь к файлу с данными.
         values_per_line (int): Ожидаемое количество значений в строке.
         lines_per_group (int): Количество строк в одной группе.
+        observed_rows (int): Для .npy с --observe - размер оси рядов (1 + число вершин), иначе 0.
     """
     all_data = []
     line_number_global = 0
 
     print(f"Чтение данных из файла: {filename}")
-    try:
-        with open(filename, 'r') as f:
-            for i, line in enumerate(f):
-                line_number_global = i + 1
-                line = line.strip()
-                if not line: # Пропускаем пустые строки
-                    continue
-                try:
-                    # Разбиваем строку по пробелам и преобразуем в числа float
-                    values = np.array(list(map(float, line.split())))
-                    # Проверяем количество значений
-                    if len(values) != values_per_line:
-                        print(f"Ошибка в строке {line_number_global}: Ожидалось {values_per_line} значений, найдено {len(values)}. Строка пропущена.", file=sys.stderr)
+    if filename.endswith('.npy'):
+        # .npy от states_calculating --npy: ряды отображаются в память без копирования, диагональ (-1) пропускается
+        try:
+            rows = np.load(filename, mmap_mode='r')
+        except (FileNotFoundError, ValueError) as e:
+            print(f"Ошибка: Не удалось прочитать '{filename}': {e}", file=sys.stderr)
+            return
+        # с --observe предпоследняя ось - ряды стока и наблюдаемых вершин, берется ряд стока; по четности осей
+        # ее не узнать, у states_calculating_incremental --deletions (n, slots, points) та же размерность
+        if observed_rows:
+            if rows.ndim < 3 or rows.shape[-2] != observed_rows:
+                print(f"Ошибка: В файле '{filename}' нет оси --observe из {observed_rows} рядов (форма {rows.shape}).", file=sys.stderr)
+                return
+            rows = rows[..., 0, :]
+        if rows.shape[-1] != values_per_line:
+            print(f"Ошибка: В файле '{filename}' {rows.shape[-1]} значений в ряду, ожидалось {values_per_line}.", file=sys.stderr)
+            return
+        rows = rows.reshape(-1, rows.shape[-1])
+        all_data = [row[9000:] for row in rows if row[0] >= 0]
+    else:
+        try:
+            with open(filename, 'r') as f:
+                for i, line in enumerate(f):
+                    line_number_global = i + 1
+                    line = line.strip()
+                    if not line: # Пропускаем пустые строки
                         continue
-                    all_data.append(values[9000:])
-                except ValueError:
-                    print(f"Ошибка в строке {line_number_global}: Не удалось преобразовать данные в числа. Строка пропущена.", file=sys.stderr)
-                    continue
-    except FileNotFoundError:
-        print(f"Ошибка: Файл '{filename}' не найден.", file=sys.stderr)
-        return
-    except Exception as e:
-        print(f"Произошла непредвиденная ошибка при чтении файла: {e}", file=sys.stderr)
-        return
+                    try:
+                        # Разбиваем строку по пробелам и преобразуем в числа float
+                        values = np.array(list(map(float, line.split())))
+                        # Проверяем количество значений
+                        if len(values) != values_per_line:
+                            print(f"Ошибка в строке {line_number_global}: Ожидалось {values_per_line} значений, найдено {len(values)}. Строка пропущена.", file=sys.stderr)
+                            continue
+                        all_data.append(values[9000:])
+                    except ValueError:
+                        print(f"Ошибка в строке {line_number_global}: Не удалось преобразовать данные в числа. Строка пропущена.", file=sys.stderr)
+                        continue
+        except FileNotFoundError:
+            print(f"Ошибка: Файл '{filename}' не найден.", file=sys.stderr)
+            return
+        except Exception as e:
+            print(f"Произошла непредвиденная ошибка при чтении файла: {e}", file=sys.stderr)
+            return
 
     if not all_data:
         print("В файле не найдено корректных данных для построения графиков.", file=sys.stderr)
@@ -120,4 +142,4 @@ def plot_grouped_data(filename, values_per_line, lines_per_group):
 
 # --- Запуск ---
 if __name__ == "__main__":
-    plot_grouped_data(FILENAME, VALUES_PER_LINE, LINES_PER_GROUP)
+    plot_grouped_data(FILENAME, VALUES_PER_LINE, LINES_PER_GROUP, OBSERVED_ROWS)
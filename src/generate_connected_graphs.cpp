@@ -0,0 +1,328 @@
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include "canonical.hpp"
+#include "graph.hpp"
+#include "graph_io.hpp"
+#include "options.hpp"
+
+// Orderly generation of connected graphs by canonical augmentation (McKay, "Isomorph-free exhaustive
+// generation", 1998). A graph on k + 1 vertices is built from its parent on k vertices by a new vertex v
+// and is accepted only if v is in the orbit of the canonical deletion vertex: the non-cut vertex with the
+// largest invariant and, on ties, the largest certificate with that vertex individualized. Every class
+// then has a single parent class, so the classes are produced exactly once with no global storage, and
+// children of one parent are deduplicated by the same certificate.
+//
+// usage: generate_connected_graphs --size N [--edges M | --min-edges A --max-edges B] [--bipartite]
+//                                  [--max-degree D] [--threads T] [--output FILE | --text]
+// without output only the number of graphs is printed
+
+const std::size_t MAX_SIZE = 32;
+
+struct SmallGraph {
+    std::size_t n = 0;
+    std::size_t m = 0;
+    std::array<std::uint32_t, MAX_SIZE> rows{};
+};
+
+struct Filters {
+    std::size_t size;
+    std::size_t min_edges;
+    std::size_t max_edges;
+    std::size_t max_degree;
+    bool bipartite;
+};
+
+bool connected_without(const SmallGraph& g, std::size_t removed) {
+    std::uint32_t all = ((std::uint64_t(1) << g.n) - 1) & ~(std::uint32_t(1) << removed);
+    if (all == 0) {
+        return true;
+    }
+    std::uint32_t reach = all & -all;
+    std::uint32_t frontier = reach;
+    while (frontier) {
+        std::uint32_t next = 0;
+        for (std::uint32_t f = frontier; f; f &= f - 1) {
+            next |= g.rows[std::countr_zero(f)];
+        }
+        next &= all & ~reach;
+        reach |= next;
+        frontier = next;
+    }
+    return reach == all;
+}
+
+// cheap isomorphism invariant of a vertex: degree, neighbour degrees, triangles and second neighbourhood
+std::uint64_t vertex_invariant(const SmallGraph& g, std::size_t v) {
+    std::uint64_t degree = std::popcount(g.rows[v]);
+    std::uint64_t nbr_degrees = 0, triangles = 0;
+    std::uint32_t second = 0;
+    for (std::uint32_t r = g.rows[v]; r; r &= r - 1) {
+        std::size_t u = std::countr_zero(r);
+        nbr_degrees += std::popcount(g.rows[u]);
+        triangles += std::popcount(g.rows[u] & g.rows[v]);
+        second |= g.rows[u];
+    }
+    second &= ~g.rows[v] & ~(std::uint32_t(1) << v);
+    return (degree << 48) | (nbr_degrees << 32) | (triangles << 8) | std::uint64_t(std::popcount(second));
+}
+
+class Enumerator {
+private:
+    const Filters& filters;
+    graph::Canonizer canonizer;
+    graph::BitGraph bit_graph;
+    std::vector<std::size_t> colours;
+    std::vector<std::uint64_t> key;
+
+    const std::vector<std::uint64_t>& certificate_with(const SmallGraph& g, std::size_t v) {
+        bit_graph.resize(g.n);
+        for (std::size_t i = 0; i < g.n; ++i) {
+            for (std::uint32_t r = g.rows[i] & ~((std::uint64_t(2) << i) - 1); r; r &= r - 1) {
+                bit_graph.add_edge(i, std::countr_zero(r));
+            }
+        }
+        colours.assign(g.n, 1);
+        colours[v] = 0;
+        return canonizer.canonize(bit_graph, colours);
+    }
+
+    // checks that the last vertex is a canonical deletion vertex, key gets the certificate of the child
+    bool is_canonical_child(const SmallGraph& g) {
+        std::size_t v = g.n - 1;
+        std::uint64_t v_inv = vertex_invariant(g, v);
+        std::vector<std::size_t> candidates;
+        for (std::size_t u = 0; u < v; ++u) {
+            std::uint64_t inv = vertex_invariant(g, u);
+            if (inv < v_inv) {
+                continue;
+            }
+            if (!connected_without(g, u)) {
+                continue;
+            }
+            if (v_inv < inv) {
+                return false;
+            }
+            candidates.push_back(u);
+        }
+
+        key = certificate_with(g, v);
+        for (auto &u : candidates) {
+            if (key < certificate_with(g, u)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    std::size_t produced = 0;
+
+    Enumerator(const Filters& filters) : filters(filters) {}
+
+    // children of g which pass the filters and the canonicity test, one per isomorphism class
+    std::vector<SmallGraph> children(const SmallGraph& g) {
+        std::vector<SmallGraph> result;
+        std::set<std::vector<std::uint64_t>> seen;
+        std::size_t k = g.n;
+        std::size_t remaining = filters.size - k - 1;
+        std::size_t future_max = (filters.size - 1) * filters.size / 2 - k * (k + 1) / 2;
+
+        // with a connected bipartite parent the new vertex can be joined to one side only
+        std::uint32_t side = 0;
+        if (filters.bipartite && k != 0) {
+            side = 1;
+            std::uint32_t frontier = 1, reached = 1;
+            bool odd = true;
+            while (frontier) {
+                std::uint32_t next = 0;
+                for (std::uint32_t f = frontier; f; f &= f - 1) {
+                    next |= g.rows[std::countr_zero(f)];
+                }
+                next &= ~reached;
+                reached |= next;
+                odd = !odd;
+                if (odd) {
+                    side |= next;
+                }
+                frontier = next;
+            }
+        }
+
+        std::uint32_t all = (std::uint64_t(1) << k) - 1;
+        for (std::uint32_t s = (k == 0 ? 0 : 1); s <= all; ++s) {
+            std::size_t added = std::popcount(s);
+            if (filters.max_edges < g.m + added + remaining || g.m + added + future_max < filters.min_edges) {
+                continue;
+            }
+            if (filters.bipartite && (s & side) != 0 && (s & ~side) != 0) {
+                continue;
+            }
+            if (filters.max_degree < added) {
+                continue;
+            }
+            bool degree_ok = true;
+            for (std::uint32_t r = s; r && degree_ok; r &= r - 1) {
+                degree_ok = std::size_t(std::popcount(g.rows[std::countr_zero(r)])) < filters.max_degree;
+            }
+            if (!degree_ok) {
+                continue;
+            }
+
+            SmallGraph child = g;
+            child.n = k + 1;
+            child.m = g.m + added;
+            child.rows[k] = s;
+            for (std::uint32_t r = s; r; r &= r - 1) {
+                child.rows[std::countr_zero(r)] |= std::uint32_t(1) << k;
+            }
+            if (k == 0) {
+                result.push_back(child);
+                continue;
+            }
+            if (is_canonical_child(child) && seen.insert(key).second) {
+                result.push_back(child);
+            }
+        }
+        return result;
+    }
+
+    template<class Emit>
+    void extend(const SmallGraph& g, Emit& emit) {
+        if (g.n == filters.size) {
+            if (filters.min_edges <= g.m) {
+                ++produced;
+                emit(g);
+            }
+            return;
+        }
+        for (auto &child : children(g)) {
+            extend(child, emit);
+        }
+    }
+};
+
+std::vector<graph::Edge> to_edges(const SmallGraph& g) {
+    std::vector<graph::Edge> edges;
+    for (std::size_t i = 0; i < g.n; ++i) {
+        for (std::uint32_t r = g.rows[i] & ~((std::uint64_t(2) << i) - 1); r; r &= r - 1) {
+            edges.emplace_back(i, std::size_t(std::countr_zero(r)));
+        }
+    }
+    return edges;
+}
+
+int main(int argc, char *argv[]) {
+    cli::Options options(argc, argv);
+    if (!options.has("size")) {
+        fprintf(stderr, "Usage: %s --size N [--edges M] [--bipartite] [--max-degree D] [--threads T] [--output FILE | --text]\n", argv[0]);
+        return -1;
+    }
+
+    Filters filters;
+    filters.size = options.get_int("size");
+    filters.min_edges = options.get_int("edges", options.get_int("min-edges", 0));
+    filters.max_edges = options.get_int("edges", options.get_int("max-edges", filters.size * filters.size));
+    filters.max_degree = options.get_int("max-degree", filters.size);
+    filters.bipartite = options.has("bipartite");
+    if (filters.size == 0 || MAX_SIZE < filters.size) {
+        fprintf(stderr, "Size should be in [1, %zu]\n", MAX_SIZE);
+        return -1;
+    }
+    std::size_t threads_cnt = options.get_int("threads", std::max(1u, std::thread::hardware_concurrency()));
+    bool text = options.has("text");
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // the top of the search tree is expanded serially until there is enough independent work
+    std::vector<SmallGraph> roots(1);
+    Enumerator top(filters);
+    while (roots.front().n < filters.size && roots.size() < 64 * threads_cnt) {
+        std::vector<SmallGraph> next;
+        for (auto &g : roots) {
+            auto children = top.children(g);
+            next.insert(next.end(), children.begin(), children.end());
+        }
+        roots = next;
+        if (roots.empty()) {
+            break;
+        }
+    }
+
+    std::fstream fout;
+    if (options.has("output")) {
+        fout = graph::create_bin_file(options.get("output"), 0);
+        fout.seekp(graph::bin_graph_offset(0, filters.size));
+    }
+
+    // subtrees are handed out in order and flushed in order, so the output does not depend on threads
+    std::atomic<std::size_t> next_root(0);
+    std::mutex flush_mutex;
+    std::map<std::size_t, std::pair<std::size_t, std::vector<SmallGraph>>> finished;
+    std::size_t next_flush = 0;
+    std::size_t total = 0;
+    std::vector<SmallGraph> text_graphs;
+    std::vector<std::int32_t> buffer;
+
+    auto flush = [&]() {
+        while (!finished.empty() && finished.begin()->first == next_flush) {
+            auto &[cnt, graphs] = finished.begin()->second;
+            for (auto &g : graphs) {
+                if (fout.is_open()) {
+                    graph::write_bin_graph(fout, g.n, to_edges(g), buffer);
+                }
+                if (text) {
+                    text_graphs.push_back(g);
+                }
+            }
+            total += cnt;
+            finished.erase(finished.begin());
+            ++next_flush;
+        }
+    };
+
+    bool keep = fout.is_open() || text;
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < std::max<std::size_t>(1, threads_cnt); ++t) {
+        workers.emplace_back([&]() {
+            Enumerator enumerator(filters);
+            std::vector<SmallGraph> found;
+            auto emit = [&](const SmallGraph& g) {
+                if (keep) {
+                    found.push_back(g);
+                }
+            };
+            for (std::size_t i = next_root++; i < roots.size(); i = next_root++) {
+                std::size_t before = enumerator.produced;
+                enumerator.extend(roots[i], emit);
+                std::lock_guard<std::mutex> lock(flush_mutex);
+                finished[i] = {enumerator.produced - before, std::move(found)};
+                found = std::vector<SmallGraph>();
+                flush();
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    if (fout.is_open()) {
+        fout.seekp(0);
+        graph::write_bin_count(fout, total);
+        fout.close();
+    }
+
+    auto stop = std::chrono::high_resolution_clock::now();
+    double duration = double((std::chrono::duration_cast<std::chrono::microseconds>(stop - start)).count()) / 1000.0;
+
+    std::cout << total << std::endl;
+    for (auto &g : text_graphs) {
+        graph::write_text_graph(std::cout, g.n, to_edges(g));
+    }
+    std::cerr << "Execution time: " << duration << " ms." << std::endl;
+    return 0;
+}
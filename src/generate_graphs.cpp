@@ -1,56 +1,143 @@
 #include <vector>
 #include <chrono>
+#include <sstream>
 #include "graph.hpp"
+#include "graph_io.hpp"
+#include "generators.hpp"
+#include "options.hpp"
+#include "rng.hpp"
 
-const int size = 40;
+// usage: generate_graphs --family F [--sizes 20:50:10] [--count C] [--output PREFIX | --text] [family parameters]
+//   circulant            --offsets 1,2          ring for offsets 1
+//   bipartite_circulant  --offsets 0,1          two groups of size / 2
+//   grid, torus          --cols C               size / C rows, the most square one by default
+//   hypercube                                   size should be a power of two
+//   random_regular       --degree D
+//   clustered            --groups G [--hubs] [--cross]
+//   gnp                  --p P
+// every size of the sweep is written to PREFIX<size>_bin, or printed as text without --output; random
+// families use Philox stream (size, graph index) of --seed, so any single graph can be regenerated alone
 
-int main(int argc, char *argv[]) {
-    graph::Graph<size> graph;
-    int group_size = size / 2;
-    //int group_cnt = size / group_size;
-
-    // get start generation time
-    auto start = std::chrono::high_resolution_clock::now();
-
-    // in-groups connection generation
-    /*
-    for (int i = 0; i < group_size; ++i) {
-        for (int j = 0; j < group_cnt; ++j) {
-            graph += {j * group_size + i, j * group_size + ((i + 1) % group_size)};
+std::vector<std::size_t> parse_list(const std::string& s) {
+    std::vector<std::size_t> result;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            result.push_back(std::stoull(item));
         }
     }
-    */
-
-    // inter-group connections
-    /*
-    for (int i = 0; i < group_cnt; ++i) {
-        for (int j = 0; j < group_cnt; ++j) {
-            if (i != j) {
-                graph += {i * group_size, j * group_size};
+    return result;
+}
+
+// "40", "20,30,40" or "first:last:step"
+std::vector<std::size_t> parse_sizes(const std::string& s) {
+    if (s.find(':') == std::string::npos) {
+        return parse_list(s);
+    }
+    std::vector<std::size_t> bounds;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ':')) {
+        bounds.push_back(std::stoull(item));
+    }
+    std::size_t step = bounds.size() > 2 ? bounds[2] : 1;
+    std::vector<std::size_t> result;
+    for (std::size_t size = bounds[0]; size <= bounds[1] && step != 0; size += step) {
+        result.push_back(size);
+    }
+    return result;
+}
+
+void make_graph(const std::string& family, std::size_t size, const cli::Options& options,
+                graph::Philox& rng, std::vector<graph::Edge>& edges) {
+    if (family == "circulant") {
+        graph::circulant(size, parse_list(options.get("offsets", "1")), edges);
+    } else if (family == "bipartite_circulant") {
+        graph::bipartite_circulant(size, parse_list(options.get("offsets", "0,1")), edges);
+    } else if (family == "grid" || family == "torus") {
+        std::size_t cols = options.get_int("cols", 0);
+        if (cols == 0) {
+            // the most square grid with this number of vertices
+            for (std::size_t c = 1; c * c <= size; ++c) {
+                if (size % c == 0) {
+                    cols = c;
+                }
             }
         }
+        if (cols == 0 || size % cols != 0) {
+            throw "Error - grid family: size should be divisible by cols";
+        }
+        graph::grid(size / cols, cols, family == "torus", edges);
+    } else if (family == "hypercube") {
+        std::size_t dim = 0;
+        while ((std::size_t(1) << dim) < size) {
+            ++dim;
+        }
+        if ((std::size_t(1) << dim) != size) {
+            throw "Error - hypercube family: size should be a power of two";
+        }
+        graph::hypercube(dim, edges);
+    } else if (family == "random_regular") {
+        graph::random_regular(size, options.get_int("degree", 3), rng, edges);
+    } else if (family == "clustered") {
+        graph::clustered(size, options.get_int("groups", 2), options.has("hubs"), options.has("cross"), edges);
+    } else if (family == "gnp") {
+        graph::random_gnp(size, options.get_double("p"), rng, edges);
+    } else {
+        throw "Error - generate graphs: unknown family";
     }
-    */
+}
 
-    for (int f = 0; f < group_size; ++f) {
-        graph += {f, group_size + (group_size + f) % group_size};
-        graph += {f, group_size + (group_size + f + 1) % group_size};
-    }
+int main(int argc, char *argv[]) {
+    cli::Options options(argc, argv);
+    std::string family = options.get("family", "bipartite_circulant");
+    std::vector<std::size_t> sizes = parse_sizes(options.get("sizes", "40"));
+    std::int64_t cnt_to_generate = options.get_int("count", 1);
+    std::uint64_t seed = options.get_int("seed", 1024);
+    // without --output the graphs are printed as text, as the tool always did
+    bool text = options.has("text") || !options.has("output");
 
-    /*
-    for (int i = 0; i < group_cnt; ++i) {
-        int cgroup = i;
-        int ngroup = (i + 1) % group_cnt;
-        graph += {cgroup * group_size + 2, ngroup * group_size + (group_size - 2)};
+    // get start generation time
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<graph::Edge> edges;
+    std::vector<std::int32_t> buffer;
+    try {
+        for (auto &size : sizes) {
+            // the family parameters are checked on the first graph before the file is created,
+            // so a rejected size leaves no file behind
+            graph::Philox first_rng(seed, std::uint64_t(size) << 32);
+            make_graph(family, size, options, first_rng, edges);
+
+            std::fstream fout;
+            if (text) {
+                std::cout << cnt_to_generate << std::endl;
+            } else {
+                fout = graph::create_bin_file(options.get("output") + std::to_string(size) + "_bin", cnt_to_generate);
+                fout.seekp(graph::bin_graph_offset(0, size));
+            }
+
+            for (std::int64_t i = 0; i < cnt_to_generate; ++i) {
+                graph::Philox rng(seed, (std::uint64_t(size) << 32) | std::uint64_t(i));
+                make_graph(family, size, options, rng, edges);
+                if (text) {
+                    graph::write_text_graph(std::cout, size, edges);
+                } else {
+                    graph::write_bin_graph(fout, size, edges, buffer);
+                }
+            }
+        }
+    } catch (const char *error) {
+        fprintf(stderr, "%s\n", error);
+        return -1;
     }
-    */
 
     // get finish generation time
     auto stop = std::chrono::high_resolution_clock::now();
     // get duration of graph generation
     double duration = double((std::chrono::duration_cast<std::chrono::microseconds>(stop - start)).count()) / 1000.0;
 
-    std::cout << graph << std::endl;
-    std::cout << "Execution time: " << duration << " ms." << std::endl;
+    std::cerr << "Execution time: " << duration << " ms." << std::endl;
     return 0;
 }
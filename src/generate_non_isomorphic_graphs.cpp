@@ -1,16 +1,65 @@
 #include <vector>
+#include <algorithm>
+#include <atomic>
+#include <bit>
 #include <chrono>
-#include "graph.hpp"
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include "combinations.hpp"
+#include "fingerprint.hpp"
+#include "options.hpp"
+#include "small_graph.hpp"
+
+// Exhaustive search for the trees of size vertices among all (size - 1)-subsets of the edges.
+//
+// usage: generate_non_isomorphic_graphs [--threads T] [--shards S] [--order lexicographic | revolving]
+// the subsets are ranked in std::prev_permutation order and cut into S shards (default 64 per thread)
+// handed out in order to the threads; every thread keeps its own classes with the rank where it saw
+// them first, and the classes are merged keeping the earliest representative, so the output is the
+// one of the serial walk whatever the number of threads
+// --order revolving walks the subsets in revolving door order instead: every step moves exactly one
+// edge out and one in, and a spanning forest is updated with them (small_graph.hpp Connectivity), so
+// the graph is searched only when a forest edge leaves;
+// the classes are the same, their representatives and order are the first ones of that walk
+
+const int size = 8;
+
+// classes of trees with their first rank, only classes with the fingerprint of a candidate are hashed
+struct Classes {
+    std::vector<graph::SmallGraph<size>> graphs;
+    std::vector<std::uint64_t> ranks;
+    graph::FingerprintTable fingerprints;
+
+    // index of the class of g, or -1
+    long long find(const graph::SmallGraph<size>& g, const graph::Fingerprint& fp) const {
+        long long result = -1;
+        fingerprints.find_if(fp, [&](std::size_t j) {
+            if (g % graphs[j]) {
+                result = j;
+                return true;
+            }
+            return false;
+        });
+        return result;
+    }
+
+    void add(const graph::SmallGraph<size>& g, const graph::Fingerprint& fp, std::uint64_t rank) {
+        graphs.push_back(g);
+        ranks.push_back(rank);
+        fingerprints.push_back(fp);
+    }
+};
 
 int main(int argc, char *argv[]) {
     std::vector<int> correct_cnt_tree = {1, 1, 1, 1, 2, 3, 6, 11, 23, 47, 106, 235};
-    const int size = 8;
 
-    std::vector<bool> combinations(size * (size - 1) / 2);
-    std::vector<std::pair<int, int>> indexes(size * (size - 1) / 2);
-    std::fill(combinations.begin(), combinations.begin() + size - 1, true);
+    cli::Options options(argc, argv);
+    bool revolving = options.get("order", "lexicographic") == "revolving";
+    std::size_t threads_cnt = std::max<long long>(1, options.get_int("threads", std::max(1u, std::thread::hardware_concurrency())));
 
-    graph::Graph<size> graph;
+    const int edges = size * (size - 1) / 2;
+    std::vector<std::pair<int, int>> indexes(edges);
 
     int step = 0;
     int first_v = 0, second_v = 1;
@@ -29,48 +78,117 @@ int main(int argc, char *argv[]) {
         step++;
     }
 
-    //std::cout << "Indexes were generated." << std::endl;
+    // a combination holds the edges of the candidate graph, edge indexes[i] is bit edges - 1 - i
+    graph::Combinations combinations(edges, size - 1);
+    graph::RevolvingDoor door(edges, size - 1);
+    std::uint64_t total = combinations.count();
+    std::uint64_t shards = std::max<long long>(1, options.get_int("shards", 64 * threads_cnt));
+    shards = std::min(shards, total);
+    auto shard_begin = [&](std::uint64_t s) {
+        return std::uint64_t((unsigned __int128) total * s / shards);
+    };
 
-    std::vector<graph::Graph<size>> not_ismorfic;
     auto start = std::chrono::high_resolution_clock::now();
 
-    int cnt = 0;
+    // the search stops once every class is known and all shards up to the last first occurrence are done
+    Classes merged;
+    std::mutex merge_mutex;
+    std::vector<bool> done(shards, false);
+    std::uint64_t done_prefix = 0;
+    std::atomic<std::uint64_t> next_shard(0);
+    std::atomic<bool> complete(false);
 
-    do {
-        if (cnt % 1000000 == 0) {
-            std::cout << "Reach step: " << cnt << std::endl;
-        }
-        for (int i = 0; i < int(combinations.size()); ++i) {
-            if (combinations[i]) {
-                graph += indexes[i];
-            } else {
-                graph -= indexes[i];
-            }
-        }
-        if (~graph) {
-            bool was_same = false;
-            for (int j = 0; j < int(not_ismorfic.size()); ++j) {
-                if (graph % not_ismorfic[j]) {
-                    was_same = true;
-                    break;
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < threads_cnt; ++t) {
+        workers.emplace_back([&]() {
+            Classes own;
+            std::size_t reported = 0;
+            for (std::uint64_t s = next_shard++; s < shards && !complete; s = next_shard++) {
+                std::uint64_t first = shard_begin(s), last = shard_begin(s + 1);
+                std::uint64_t combination = revolving ? door.unrank(first) : combinations.unrank(first), applied = 0;
+                graph::SmallGraph<size> graph;
+                graph::Connectivity<size> connectivity;
+                auto edge = [&](std::uint64_t bit) -> auto& {
+                    return indexes[edges - 1 - std::countr_zero(bit)];
+                };
+
+                for (std::uint64_t r = first; r < last; ++r) {
+                    bool connected;
+                    if (revolving && r != first) {
+                        std::uint64_t next = door.next(combination);
+                        auto &in = edge(next & ~combination), &out = edge(combination & ~next);
+                        graph.toggle(in.first, in.second);
+                        connectivity.inserted(in.first, in.second);
+                        graph.toggle(out.first, out.second);
+                        connectivity.erased(graph, out.first, out.second);
+                        combination = next;
+                        connected = connectivity.connected();
+                    } else {
+                        if (r != first) {
+                            combination = combinations.previous(combination);
+                        }
+                        // consecutive combinations differ in few edges
+                        for (std::uint64_t changed = combination ^ applied; changed; changed &= changed - 1) {
+                            auto &e = edge(changed & -changed);
+                            graph.toggle(e.first, e.second);
+                        }
+                        applied = combination;
+                        if (revolving) {
+                            connectivity.reset(graph);
+                        }
+                        connected = revolving ? connectivity.connected() : ~graph;
+                    }
+                    if (connected) {
+                        auto fp = graph::fingerprint(graph);
+                        if (own.find(graph, fp) < 0) {
+                            own.add(graph, fp, r);
+                        }
+                    }
                 }
-            }
 
-            if (!was_same) {
-                not_ismorfic.push_back(graph);
-            }
-            if (correct_cnt_tree[size] == int(not_ismorfic.size())) {
-                break;
+                std::lock_guard<std::mutex> lock(merge_mutex);
+                for (; reported < own.graphs.size(); ++reported) {
+                    auto fp = own.fingerprints[reported];
+                    long long j = merged.find(own.graphs[reported], fp);
+                    if (j < 0) {
+                        merged.add(own.graphs[reported], fp, own.ranks[reported]);
+                    } else if (own.ranks[reported] < merged.ranks[j]) {
+                        merged.graphs[j] = own.graphs[reported];
+                        merged.ranks[j] = own.ranks[reported];
+                    }
+                }
+                done[s] = true;
+                while (done_prefix < shards && done[done_prefix]) {
+                    ++done_prefix;
+                }
+                if (size < int(correct_cnt_tree.size()) && correct_cnt_tree[size] == int(merged.graphs.size())) {
+                    std::uint64_t latest = *std::max_element(merged.ranks.begin(), merged.ranks.end());
+                    if (latest < shard_begin(done_prefix)) {
+                        complete = true;
+                    }
+                }
             }
-        }
-        ++cnt;
-    } while (std::prev_permutation(combinations.begin(), combinations.end()));
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    // classes in the order of their first occurrence
+    std::vector<std::size_t> order(merged.graphs.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return merged.ranks[a] < merged.ranks[b];
+    });
+
     auto stop = std::chrono::high_resolution_clock::now();
     double duration = double((std::chrono::duration_cast<std::chrono::microseconds>(stop - start)).count()) / 1000.0;
 
-    std::cout << not_ismorfic.size() << std::endl;
-    for (int i = 0; i < int(not_ismorfic.size()); ++i) {
-        std::cout << not_ismorfic[i] << std::endl;
+    std::cout << merged.graphs.size() << std::endl;
+    for (auto i : order) {
+        std::cout << merged.graphs[i] << std::endl;
     }
     std::cout << "Execution time: " << duration << " ms." << std::endl;
     return 0;
@@ -0,0 +1,71 @@
+#include <vector>
+#include <chrono>
+#include <thread>
+#include "graph.hpp"
+#include "graph_io.hpp"
+#include "generators.hpp"
+#include "options.hpp"
+#include "rng.hpp"
+
+// usage: generate_random_graphs --output FILE --size N --p P --count C [--seed S] [--threads T]
+// graph i is drawn from Philox stream i of the seed, so the output does not depend on --threads
+int main(int argc, char *argv[]) {
+    cli::Options options(argc, argv);
+    if (!options.has("output") || !options.has("size") || !options.has("p") || !options.has("count")) {
+        fprintf(stderr, "Usage: %s --output FILE --size N --p P --count C [--seed S] [--threads T]\n", argv[0]);
+        return -1;
+    }
+
+    std::string output = options.get("output");
+    std::size_t size = options.get_int("size");
+    double p = options.get_double("p");
+    std::int64_t cnt_to_generate = options.get_int("count");
+    std::uint64_t seed = options.get_int("seed", 1024);
+    std::int64_t threads_cnt = options.get_int("threads", std::max(1u, std::thread::hardware_concurrency()));
+    threads_cnt = std::max<std::int64_t>(1, std::min(threads_cnt, cnt_to_generate));
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    try {
+        graph::create_bin_file(output, cnt_to_generate).close();
+    } catch (const char *error) {
+        fprintf(stderr, "%s: %s\n", error, output.c_str());
+        return -1;
+    }
+
+    std::vector<std::size_t> edges_cnt(threads_cnt, 0);
+    std::vector<std::thread> workers;
+    for (std::int64_t t = 0; t < threads_cnt; ++t) {
+        workers.emplace_back([&, t]() {
+            std::int64_t first = cnt_to_generate * t / threads_cnt;
+            std::int64_t last = cnt_to_generate * (t + 1) / threads_cnt;
+
+            std::fstream fout(output, std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+            fout.seekp(graph::bin_graph_offset(first, size));
+
+            std::vector<graph::Edge> edges;
+            std::vector<std::int32_t> buffer;
+            for (std::int64_t i = first; i < last; ++i) {
+                graph::Philox rng(seed, i);
+                graph::random_gnp(size, p, rng, edges);
+                graph::write_bin_graph(fout, size, edges, buffer);
+                edges_cnt[t] += edges.size();
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    auto stop = std::chrono::high_resolution_clock::now();
+    double duration = double((std::chrono::duration_cast<std::chrono::microseconds>(stop - start)).count()) / 1000.0;
+
+    std::size_t total_edges = 0;
+    for (auto &cnt : edges_cnt) {
+        total_edges += cnt;
+    }
+    std::cerr << "Generated " << cnt_to_generate << " graphs, mean edge count: "
+              << double(total_edges) / double(std::max<std::int64_t>(1, cnt_to_generate)) << std::endl;
+    std::cerr << "Execution time: " << duration << " ms." << std::endl;
+    return 0;
+}
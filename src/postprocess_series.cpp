@@ -0,0 +1,264 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "isotonic.hpp"
+#include "npy.hpp"
+#include "options.hpp"
+#include "series_store.hpp"
+
+// Post-processing of the series files of states_calculating for the plots: monotonic fits, tail
+// normalisation and monotonicity statistics of every series, so the drawing scripts only draw.
+//
+// usage: postprocess_series INPUT [--fit PATH] [--tail PATH] [--stats PATH] [--pair] [--points P] [--t-max T]
+//                           [--tail-from A] [--tail-to B] [--threads K] [--npy]
+// INPUT is a series file: raw, .npy or a --store store; --pair for files written with --pair. The sink series
+// of a record (its first P values, P is the last axis of a .npy or of the store and the whole record of a raw
+// file by default) is fitted:
+//   fit    P doubles, the non-decreasing least squares fit clipped at 0 and divided by its largest value
+//          (not divided when that is below 1e-9), the curve draw-functions.py draws
+//   tail   the fit at the points with t in [A, B], default [480, 500] of t = linspace(0, T = 500, P)
+//   stats  6 doubles: the final value, the largest value of the fit before division, the number of
+//          decreasing steps, their total and largest drop, the largest distance between series and fit
+// Every output has the layout of the input, int n, int size and the records, or a .npy file with --npy;
+// records whose first value is negative (the diagonal) stay -1. Blocks of records are handed out to the
+// threads in order and read and written in place, memory does not depend on the size of the file.
+
+enum Output { FIT, TAIL, STATS, OUTPUTS };
+const char *OUTPUT_NAMES[OUTPUTS] = {"fit", "tail", "stats"};
+
+const std::size_t STATS_RECORD = 6;
+const std::size_t BLOCK = 256;
+
+enum Format { RAW, NPY, STORE };
+
+int main(int argc, char *argv[]) {
+    cli::Options options(argc, argv);
+    if (options.positional_count() < 1) {
+        fprintf(stderr, "Not enough arguments (give path to the series file as argument)\n");
+        return -1;
+    }
+    std::string input = options[0];
+    bool single_pair = options.has("pair");
+    std::size_t threads_cnt = std::max<long long>(1, options.get_int("threads", std::max(1u, std::thread::hardware_concurrency())));
+
+    // layout of the input: records of length values, the sink series is the first points of them
+    Format format = RAW;
+    std::uint64_t n = 0, size = 0, records = 0, values = 0, points = 0, data_offset = 8;
+    try {
+        std::ifstream fin(input, std::ios::binary);
+        std::uint64_t magic = 0;
+        if (!fin.read((char *) &magic, 8)) {
+            fprintf(stderr, "Couldn't read file: %s\n", input.c_str());
+            return -1;
+        }
+        if (magic == conductivity::StoreHeader::MAGIC) {
+            format = STORE;
+            conductivity::SeriesStore store(input);
+            auto &h = store.header();
+            n = h.n;
+            size = h.size;
+            records = h.records;
+            values = points = h.points;
+            single_pair = h.per_graph == 1;
+        } else if (std::string((char *) &magic, 6) == "\x93NUMPY") {
+            format = NPY;
+            fin.seekg(0);
+            std::size_t offset;
+            auto shape = npy::read_header(fin, offset);
+            data_offset = offset;
+            std::size_t axes = single_pair ? 1 : 3;
+            if (shape.size() <= axes || (!single_pair && shape[1] != shape[2])) {
+                fprintf(stderr, "Shape of %s is not the one of a series file\n", input.c_str());
+                return -1;
+            }
+            n = shape[0];
+            size = single_pair ? 0 : shape[1];
+            records = single_pair ? n : n * size * size;
+            values = 1;
+            for (std::size_t i = axes; i < shape.size(); ++i) {
+                values *= shape[i];
+            }
+            points = shape.back();
+        } else {
+            n = std::uint32_t(magic);
+            size = std::uint32_t(magic >> 32);
+            records = single_pair ? n : n * size * size;
+            std::uint64_t bytes = std::filesystem::file_size(input) - 8;
+            if (records == 0 || bytes % (8 * records) != 0) {
+                fprintf(stderr, "Length of %s is not the one of a series file (written with --pair?)\n", input.c_str());
+                return -1;
+            }
+            values = points = bytes / (8 * records);
+        }
+    } catch (const char *message) {
+        fprintf(stderr, "%s\n", message);
+        return -1;
+    }
+    points = options.get_int("points", points);
+    if (points < 2 || values < points) {
+        fprintf(stderr, "Records of %llu values hold no series of %llu points\n", (unsigned long long) values,
+                (unsigned long long) points);
+        return -1;
+    }
+
+    double t_max = options.get_double("t-max", 500);
+    double tail_from = options.get_double("tail-from", 480), tail_to = options.get_double("tail-to", 500);
+    std::size_t tail_begin = points, tail_end = 0;
+    for (std::size_t j = 0; j < points; ++j) {
+        double t = t_max * double(j) / double(points - 1);
+        if (tail_from <= t && t <= tail_to) {
+            tail_begin = std::min(tail_begin, j);
+            tail_end = j + 1;
+        }
+    }
+    std::array<std::uint64_t, OUTPUTS> lengths = {points, tail_end - std::min(tail_begin, tail_end), STATS_RECORD};
+
+    std::array<std::string, OUTPUTS> paths;
+    std::array<int, OUTPUTS> outputs;
+    std::array<std::uint64_t, OUTPUTS> header;
+    bool any = false;
+    for (int o = 0; o < OUTPUTS; ++o) {
+        paths[o] = options.get(OUTPUT_NAMES[o], "");
+        any = any || !paths[o].empty();
+    }
+    if (!any || (!paths[TAIL].empty() && lengths[TAIL] == 0)) {
+        fprintf(stderr, "No output requested (or no point of the series in the tail window)\n");
+        return -1;
+    }
+    for (int o = 0; o < OUTPUTS; ++o) {
+        outputs[o] = -1;
+        if (paths[o].empty()) {
+            continue;
+        }
+        outputs[o] = open(paths[o].c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (outputs[o] < 0) {
+            fprintf(stderr, "Couldn't open file for writing: %s\n", paths[o].c_str());
+            return -1;
+        }
+        std::string head;
+        if (options.has("npy")) {
+            std::vector<std::size_t> shape = {n};
+            if (!single_pair) {
+                shape.insert(shape.end(), {size, size});
+            }
+            shape.push_back(lengths[o]);
+            head = npy::header(shape);
+        } else {
+            int n_int = n, size_int = size;
+            head.append((char *) &n_int, 4);
+            head.append((char *) &size_int, 4);
+        }
+        header[o] = head.size();
+        if (pwrite(outputs[o], head.data(), head.size(), 0) != ssize_t(head.size())) {
+            fprintf(stderr, "Couldn't write file: %s\n", paths[o].c_str());
+            return -1;
+        }
+    }
+    int fin = format == STORE ? -1 : open(input.c_str(), O_RDONLY);
+
+    std::atomic<std::uint64_t> next_block(0);
+    std::atomic<const char *> failure(nullptr);
+    auto work = [&]() {
+        try {
+            conductivity::IsotonicFit isotonic;
+            std::unique_ptr<conductivity::SeriesStore> store;
+            if (format == STORE) {
+                store = std::make_unique<conductivity::SeriesStore>(input);
+            }
+            std::vector<double> block, record, fit(points);
+            std::array<std::vector<double>, OUTPUTS> out;
+
+            for (std::uint64_t b = next_block++; b * BLOCK < records && !failure; b = next_block++) {
+                std::uint64_t first = b * BLOCK, count = std::min<std::uint64_t>(BLOCK, records - first);
+                if (store) {
+                    block.resize(count * values);
+                    for (std::uint64_t r = 0; r < count; ++r) {
+                        if (!store->read(first + r, record)) {
+                            record.assign(values, -1);
+                        }
+                        std::copy(record.begin(), record.begin() + values, block.begin() + r * values);
+                    }
+                } else {
+                    block.resize(count * values);
+                    std::size_t bytes = 8 * block.size();
+                    if (pread(fin, block.data(), bytes, data_offset + 8 * first * values) != ssize_t(bytes)) {
+                        throw "Error - postprocess: truncated input";
+                    }
+                }
+
+                for (int o = 0; o < OUTPUTS; ++o) {
+                    out[o].resize(count * lengths[o]);
+                }
+                for (std::uint64_t r = 0; r < count; ++r) {
+                    const double *y = block.data() + r * values;
+                    if (y[0] < 0) {
+                        for (int o = 0; o < OUTPUTS; ++o) {
+                            std::fill(out[o].begin() + r * lengths[o], out[o].begin() + (r + 1) * lengths[o], -1);
+                        }
+                        continue;
+                    }
+                    isotonic.fit(y, points, fit.data(), 0);
+                    double largest = fit[points - 1], distance = 0;
+                    for (std::size_t j = 0; j < points; ++j) {
+                        distance = std::max(distance, std::abs(fit[j] - y[j]));
+                    }
+                    conductivity::Monotonicity monotonicity(y, points);
+                    double scale = largest < 1e-9 ? 1 : largest;
+
+                    double *f = out[FIT].data() + r * lengths[FIT];
+                    for (std::size_t j = 0; j < points; ++j) {
+                        f[j] = fit[j] / scale;
+                    }
+                    std::copy(f + tail_begin, f + tail_begin + lengths[TAIL], out[TAIL].begin() + r * lengths[TAIL]);
+                    std::array<double, STATS_RECORD> stats = {y[points - 1], largest, double(monotonicity.violations),
+                                                              monotonicity.total_drop, monotonicity.largest_drop, distance};
+                    std::copy(stats.begin(), stats.end(), out[STATS].begin() + r * lengths[STATS]);
+                }
+
+                for (int o = 0; o < OUTPUTS; ++o) {
+                    if (outputs[o] < 0) {
+                        continue;
+                    }
+                    std::size_t bytes = 8 * out[o].size();
+                    if (pwrite(outputs[o], out[o].data(), bytes, header[o] + 8 * first * lengths[o]) != ssize_t(bytes)) {
+                        throw "Error - postprocess: couldn't write output";
+                    }
+                }
+            }
+        } catch (const char *message) {
+            failure = message;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < threads_cnt; ++t) {
+        workers.emplace_back(work);
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    if (fin != -1) {
+        close(fin);
+    }
+    for (int o = 0; o < OUTPUTS; ++o) {
+        if (outputs[o] != -1) {
+            close(outputs[o]);
+        }
+    }
+    if (failure) {
+        fprintf(stderr, "%s\n", failure.load());
+        return -1;
+    }
+    return 0;
+}
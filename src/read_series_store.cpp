@@ -0,0 +1,96 @@
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "npy.hpp"
+#include "options.hpp"
+#include "series_store.hpp"
+
+// Reader of the compressed series stores written by states_calculating --store.
+//
+// usage: read_series_store STORE                              layout and size of the store
+//        read_series_store STORE --pair GRAPH,START,FINISH     one record, a line per point (a column per row)
+//        read_series_store STORE --record I                    the same by record index
+//        read_series_store STORE --export PATH [--npy]         every record as the raw series file the engine
+//                                                              writes (.npy with --npy), missing records as -1
+
+int main(int argc, char *argv[]) {
+    cli::Options options(argc, argv);
+    if (options.positional_count() < 1) {
+        fprintf(stderr, "Not enough arguments (give path to the store as argument)\n");
+        return -1;
+    }
+
+    try {
+        conductivity::SeriesStore store(options[0]);
+        auto &h = store.header();
+        std::vector<double> values;
+
+        if (options.has("pair") || options.has("record")) {
+            std::uint64_t index;
+            if (options.has("record")) {
+                index = options.get_int("record");
+            } else {
+                std::string pair = options.get("pair");
+                std::size_t first = pair.find(','), second = pair.find(',', first + 1);
+                index = store.index(std::stoul(pair.substr(0, first)), std::stoul(pair.substr(first + 1, second - first - 1)),
+                                    std::stoul(pair.substr(second + 1)));
+            }
+            if (!store.read(index, values)) {
+                fprintf(stderr, "Record %llu was not written\n", (unsigned long long) index);
+                return -1;
+            }
+            for (std::size_t j = 0; j < h.points; ++j) {
+                for (std::size_t row = 0; row < h.rows; ++row) {
+                    printf(row ? " %.10g" : "%.10g", values[row * h.points + j]);
+                }
+                printf("\n");
+            }
+            return 0;
+        }
+
+        if (options.has("export")) {
+            std::ofstream fout(options.get("export"), std::ios::binary);
+            if (!fout) {
+                fprintf(stderr, "Couldn't open file for writing: %s\n", options.get("export").c_str());
+                return -1;
+            }
+            if (options.has("npy")) {
+                std::vector<std::size_t> shape = {h.n};
+                if (h.per_graph != 1) {
+                    shape.insert(shape.end(), {h.size, h.size});
+                }
+                if (1 < h.rows) {
+                    shape.push_back(h.rows);
+                }
+                shape.push_back(h.points);
+                fout << npy::header(shape);
+            } else {
+                int n = h.n, size = h.size;
+                fout.write((char *) &n, 4);
+                fout.write((char *) &size, 4);
+            }
+            std::vector<double> missing(h.values(), -1);
+            for (std::uint64_t index = 0; index < h.records; ++index) {
+                auto &record = store.read(index, values) ? values : missing;
+                fout.write((char *) record.data(), 8 * record.size());
+            }
+            return 0;
+        }
+
+        std::uint64_t written = 0;
+        for (std::uint64_t index = 0; index < h.records; ++index) {
+            written += store.entry(index).length != 0;
+        }
+        double stored = h.data_begin() + h.data_bytes, raw = 8 + 8.0 * h.records * h.values();
+        printf("graphs %u, size %u, %s\n", h.n, h.size, h.per_graph == 1 ? "one pair per graph" : "all pairs");
+        printf("records %llu (%llu written) of %u x %u values\n", (unsigned long long) h.records,
+               (unsigned long long) written, h.rows, h.points);
+        printf("tolerance %g, difference order %u, chunks of %u values\n", h.step / 2, h.order, h.chunk);
+        printf("%.0f bytes, %.0f as raw series (%.1fx)\n", stored, raw, raw / stored);
+    } catch (const char *message) {
+        fprintf(stderr, "%s\n", message);
+        return -1;
+    }
+    return 0;
+}
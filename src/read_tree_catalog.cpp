@@ -0,0 +1,108 @@
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "options.hpp"
+#include "tree_catalog.hpp"
+
+// Reader of the tree catalogs written by generate_tree_catalog.
+//
+// usage: read_tree_catalog CATALOG                                       sizes and tree counts
+//        read_tree_catalog CATALOG --size S --index I                    edges of tree I, a line per edge
+//        read_tree_catalog CATALOG --size S --rank GRAPHS                index of every graph of a binary
+//                                                                        graph file of size S, a line each
+//        read_tree_catalog CATALOG --size S --export PATH [--trees A,B]  trees A .. B (all by default) as a
+//                                                                        binary graph file
+// Trees are numbered from 0 and vertex 0 of an unranked tree is its centre.
+
+int main(int argc, char *argv[]) {
+    cli::Options options(argc, argv);
+    if (options.positional_count() < 1) {
+        fprintf(stderr, "Not enough arguments (give path to the catalog as argument)\n");
+        return -1;
+    }
+
+    try {
+        graph::TreeCatalog catalog(options[0]);
+        std::size_t size = options.get_int("size", 0);
+        if (!options.has("index") && !options.has("rank") && !options.has("export")) {
+            for (std::size_t s = 1; s <= catalog.header().max_size; ++s) {
+                printf("size %zu: %llu trees\n", s, (unsigned long long) catalog.count(s));
+            }
+            return 0;
+        }
+        if (catalog.count(size) == 0) {
+            fprintf(stderr, "No trees of size %zu in the catalog\n", size);
+            return -1;
+        }
+
+        if (options.has("index")) {
+            for (auto &e : catalog.unrank(size, options.get_int("index"))) {
+                printf("%zu %zu\n", e[0], e[1]);
+            }
+            return 0;
+        }
+
+        if (options.has("rank")) {
+            std::ifstream fin(options.get("rank"), std::ios::binary);
+            int n = 0, graph_size = 0;
+            if (!fin.read((char *) &n, 4) || n < 0) {
+                fprintf(stderr, "Couldn't read file: %s\n", options.get("rank").c_str());
+                return -1;
+            }
+            std::vector<int> matrix;
+            std::vector<graph::Edge> edges;
+            for (int step = 0; step < n; ++step) {
+                if (!fin.read((char *) &graph_size, 4) || graph_size != int(size)) {
+                    fprintf(stderr, "Graph %d is not of size %zu\n", step, size);
+                    return -1;
+                }
+                matrix.resize(size * size);
+                fin.read((char *) matrix.data(), 4 * matrix.size());
+                edges.clear();
+                for (std::size_t i = 0; i < size; ++i) {
+                    for (std::size_t j = i + 1; j < size; ++j) {
+                        if (matrix[i * size + j]) {
+                            edges.emplace_back(i, j);
+                        }
+                    }
+                }
+                printf("%llu\n", (unsigned long long) catalog.rank(size, edges));
+            }
+            return 0;
+        }
+
+        std::uint64_t first = 0, last = catalog.count(size) - 1;
+        if (options.has("trees")) {
+            std::string trees = options.get("trees");
+            std::size_t comma = trees.find(',');
+            first = std::stoull(trees.substr(0, comma));
+            last = comma == std::string::npos ? first : std::stoull(trees.substr(comma + 1));
+        }
+        std::vector<std::uint64_t> codes;
+        catalog.codes(size, first, last + 1, codes);
+        std::ofstream fout(options.get("export"), std::ios::binary);
+        if (!fout) {
+            fprintf(stderr, "Couldn't open file for writing: %s\n", options.get("export").c_str());
+            return -1;
+        }
+        int n = codes.size(), graph_size = size;
+        fout.write((char *) &n, 4);
+        std::vector<int> matrix(size * size);
+        for (auto code : codes) {
+            std::fill(matrix.begin(), matrix.end(), 0);
+            for (auto &e : graph::TreeCode::decode(size, code)) {
+                matrix[e[0] * size + e[1]] = matrix[e[1] * size + e[0]] = 1;
+            }
+            fout.write((char *) &graph_size, 4);
+            fout.write((char *) matrix.data(), 4 * matrix.size());
+        }
+    } catch (const char *message) {
+        fprintf(stderr, "%s\n", message);
+        return -1;
+    } catch (const std::exception &e) {
+        fprintf(stderr, "Incorrect argument: %s\n", e.what());
+        return -1;
+    }
+    return 0;
+}
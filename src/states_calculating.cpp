@@ -1,183 +1,757 @@
-#include "QComputations_CPU_CLUSTER_NO_PLOTS.hpp"
-//#include "QComputations_SINGLE_NO_PLOTS.hpp"
+#include <mpi.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <climits>
 #include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <string>
 #include <vector>
+#include "cache.hpp"
+#include "conductivity.hpp"
+#include "fock.hpp"
+#include "graph.hpp"
+#include "mpi_io.hpp"
+#include "observables.hpp"
+#include "options.hpp"
+#include "quotient.hpp"
+#include "sampling.hpp"
+#include "screen.hpp"
+#include "tree_catalog.hpp"
+// Conductivity engine: the one-photon Hamiltonian is assembled in CSR from the edge list and evolved with the
+// Krylov propagator, O(n + m) memory; every pair is solved once and all its observables come from that solve.
+//
+// usage: mpirun states_calculating INPUT [SERIES] [--series PATH] [--final PATH] [--threshold-time PATH --threshold X]
+//                                  [--integral PATH] [--peak PATH] [--pair START,FINISH] [--coupling G] [--phase PHI]
+//                                  [--leak L] [--t-max T] [--points P] [--photons K] [--photon-starts V1,V2,...]
+//                                  [--memory-limit MB] [--cache DIR] [--observe V1,V2,...] [--npy] [--no-quotient]
+//                                  [--store PATH [--store-tolerance E] [--store-order K]]
+//                                  [--screen PATH [--screen-points P]] [--screen-threshold X]
+//        mpirun states_calculating INPUT --sample PATH [--precision E] [--bins B] [--range LO,HI] [--batch K]
+//                                  [--seed S] [physics options]
+//        mpirun states_calculating CATALOG --tree-size S [--trees FIRST,LAST] [options]
+//        mpirun states_calculating --manifest JOBS [--ranks-per-job K] [options of every job]
+// every observable goes to its own file: int n, int size, then a record per pair at index (step * size + start)
+// * size + finish (step with --pair), -1 on the diagonal; series is the sink population on linspace(0, t_max,
+// points), final its last value, threshold-time the first time it reaches X (-1 if never), integral its area,
+// peak the largest rate d sink / dt and its time; --npy writes .npy files of shape (n, size, size, ...)
+// final is taken at t_max: the defaults (t_max 500, 2000 points) give the series of the old series driver,
+// the sigma files of the old sigma driver (t = 1000) are --final with --t-max 1000, one run per layout
+// --photons K is 1 - (1 - p)^K of K photons in the start cavity, --photon-starts puts the others in V1, ...
+// and evolves their sector of C(size + K - 1, K) states, refused above --memory-limit (default 4096 MB)
+// --observe appends the population series of the vertices to every series record
+// --cache looks every series up in DIR, shared by ranks and runs, by the canonical form of the pair
+// (one-photon sink series of real waveguides, sin(phase) = 0, only)
+// pairs of real waveguides are solved in an equitable quotient of at most size / 2 cells (quotient.hpp)
+// --store writes the series compressed to within E (default 1e-8), read_series_store reads them
+// --screen writes the closed walk screen of every pair (screen.hpp), --screen-threshold skips the pairs below X;
+// the screen bounds the closed walk, not the sink population, so the skipped pairs are a heuristic choice
+// --sample estimates the distribution of the final population over the pairs of every graph to E (default 0.02)
+// a tree catalog of generate_tree_catalog as INPUT runs its trees FIRST .. LAST of S vertices as the graphs
+// --manifest runs a job per line of JOBS (INPUT [SERIES] [options]) largest first on groups of K ranks
+// all-pairs runs read the graph and build its screen once per host (mpi_io.hpp NodeShared)
 
-void READ_n(MPI_File *fin, int *n) {
-    //MPI_File_read_at_all(*fin, 0, n, 1, MPI_INT, MPI_STATUS_IGNORE);
-    MPI_File_read(*fin, n, 1, MPI_INT, MPI_STATUS_IGNORE);
+enum Observable { SERIES, FINAL, THRESHOLD_TIME, INTEGRAL, PEAK, STORE, SCREEN, SAMPLE, OBSERVABLES };
+const char *OBSERVABLE_NAMES[OBSERVABLES] = {"series", "final", "threshold-time", "integral", "peak", "store", "screen",
+                                             "sample"};
+
+const double SAMPLE_QUANTILES[] = {0.05, 0.25, 0.5, 0.75, 0.95};
+
+// --sample record: pairs, solves, LO, HI, (value, low, high) of every quantile, (probability, half-width) of every bin
+std::size_t SAMPLE_RECORD(std::size_t bins) {
+    return 4 + 3 * std::size(SAMPLE_QUANTILES) + 2 * bins;
 }
 
-void READ_graph(MPI_File *fin, int step, std::vector<std::vector<bool>> &graph) {
-    int gsz = graph.size();
-    MPI_Offset start_of_graph = 4 + step * (4 + 4 * gsz * gsz) + 4;
-    for (int i = 0; i < graph.size(); ++i) {
-        for (int j = 0; j < graph.size(); ++j) {
-            int num;
-            MPI_File_read_at(*fin, start_of_graph, &num, 1, MPI_INT, MPI_STATUS_IGNORE);
-            graph[i][j] = num;   
-            start_of_graph += 4;
-        }
+// trees FIRST .. LAST of --trees (all by default) of --tree-size vertices of a catalog, false if it has none of them
+bool tree_range(const cli::Options &options, graph::TreeCatalog &catalog, std::uint64_t &first, std::uint64_t &last) {
+    std::uint64_t count = catalog.count(options.get_int("tree-size", 0));
+    first = 0;
+    last = count - 1;
+    if (options.has("trees")) {
+        std::string trees = options.get("trees");
+        first = std::stoull(trees.substr(0, trees.find(',')));
+        last = trees.find(',') == std::string::npos ? first : std::stoull(trees.substr(trees.find(',') + 1));
     }
+    return first <= last && last < count && last - first < INT_MAX;
 }
 
-void WRITE_n(MPI_File *fout, int n, int size) {
-    MPI_File_write_at(*fout, 0, &n, 1, MPI_INT, MPI_STATUS_IGNORE);
-    MPI_File_write_at(*fout, 4, &size, 1, MPI_INT, MPI_STATUS_IGNORE);
+std::vector<std::size_t> parse_vertices(const std::string &list) {
+    std::vector<std::size_t> vertices;
+    for (std::size_t pos = 0; pos < list.size();) {
+        std::size_t next = std::min(list.find(',', pos), list.size());
+        vertices.push_back(std::stoul(list.substr(pos, next - pos)));
+        pos = next + 1;
+    }
+    return vertices;
 }
 
-void WRITE_result(MPI_File *fout, int step, int start, int finish, double *p, int size) {
-    //MPI_Offset off = 8 + step * (8 * size * size) + 8 * start * size + 8 * finish;
-    MPI_Offset off = 8 + step * (8 * 2000);
-    MPI_File_write_at(*fout, off, p, 2000, MPI_DOUBLE, MPI_STATUS_IGNORE);
-}
+// the files, parameters and solvers of one run shared by its modes
+struct Engine {
+    MPI_Comm comm;
+    int rank, world_size;
+    const cli::Options &options;
+
+    conductivity::Parameters params;
+    std::vector<std::size_t> photon_starts, observed;
+    std::size_t photons;
+    // photons in different cavities need the sector, photons in one cavity the one-photon walk only
+    bool sector;
+    double threshold, screen_threshold;
+
+    MPI_File fin;
+    std::array<std::string, OBSERVABLES> paths;
+    std::array<MPI_File, OBSERVABLES> outputs;
+    int n = -1, size = 0;
+    // the trees of a catalog input are decoded from their codes, read at once
+    std::vector<std::uint64_t> tree_codes;
+    std::unique_ptr<GraphReader> reader;
+    std::vector<graph::Edge> edges;
+
+    // results are written behind the computation, graphs are read one ahead of it
+    std::array<std::unique_ptr<ResultWriter>, OBSERVABLES> writers;
+    std::unique_ptr<StoreWriter> store;
+    std::array<std::vector<double>, OBSERVABLES> diagonal;
 
-template<std::size_t size>
-double* get_conductivity(const std::vector<std::vector<bool>>& graph, std::size_t start, std::size_t finish) {
-    using namespace QComputations;
-    std::vector<size_t> grid_atoms(size, 0); // задаёт количество частиц в каждой полости, у нас везде будут 0
-    //for (size_t i = 0; i < size; i++){ // size - number of cavities
-    //    grid_atoms.emplace_back(0);
-    //}
+    linalg::KrylovPropagator propagator;
+    bool use_quotient = false;
+    conductivity::EquitableQuotient quotient;
+    std::size_t reduced = 0;
+    std::optional<conductivity::ResultCache> cache;
 
-    //std::pair<double, double> gamma = std::make_pair(0.01, 2*M_PI), pair_zero = std::make_pair(0, 0);
-    //auto contruct_argument = graph.convert_to_system(gamma, pair_zero);
-    //Matrix<std::pair<double, double>> waveguides_parametrs(contruct_argument); // матрица параметров
+    bool screening = false, solving = false;
+    std::size_t screen_points = 0, screened_out = 0;
+    conductivity::WalkScreen screen;
 
-    TCH_State state(grid_atoms);
-    for (size_t i = 0; i < size; i++) {
-        for (size_t j = 0; j < size; j++) {
-            if (graph[i][j]) {
-                state.set_waveguide(i, j, 0.09, 2*M_PI);
+    Engine(MPI_Comm comm, const cli::Options &options) : comm(comm), options(options) {
+        MPI_Comm_rank(comm, &this->rank);
+        MPI_Comm_size(comm, &this->world_size);
+        this->params.coupling = options.get_double("coupling", this->params.coupling);
+        this->params.phase = options.get_double("phase", this->params.phase);
+        this->params.leak = options.get_double("leak", this->params.leak);
+        this->params.t_max = options.get_double("t-max", this->params.t_max);
+        this->params.points = options.get_int("points", this->params.points);
+        this->photon_starts = parse_vertices(options.get("photon-starts", ""));
+        this->observed = parse_vertices(options.get("observe", ""));
+        this->photons = options.get_int("photons", 1 + this->photon_starts.size());
+        this->sector = !this->photon_starts.empty();
+        this->threshold = options.get_double("threshold", -1);
+        this->screen_threshold = options.get_double("screen-threshold", -1);
+    }
+
+    void close_all() {
+        MPI_File_close(&this->fin);
+        for (int o = 0; o < OBSERVABLES; ++o) {
+            if (!this->paths[o].empty()) {
+                MPI_File_close(&this->outputs[o]);
             }
         }
     }
 
-    state.set_n(1, start); // в 0 полость помещаем 1 фотон
-    state.set_leak_for_cavity(finish, 0.012); // для 2 полости делаем утечки 0.001
-    
-    //std::cout << state.cavities_count() << std::endl;
+    void read_graph(int step, int next) {
+        if (this->tree_codes.empty()) {
+            this->reader->read(step, next, this->edges);
+        } else {
+            this->edges = graph::TreeCode::decode(this->size, this->tree_codes[step]);
+        }
+    }
 
-    auto A_func = std::function<State<TCH_State>(const TCH_State&)>{[](const TCH_State& state){
-        State<TCH_State> res;
-        for (int i = 0; i < state.cavities_count(); i++) {
-            int ph = state.get_qudit(0, i);
-            if (ph != 0) {
-                res += set_qudit(state, ph - 1, 0, i) * state.get_leak_gamma(i);
+    void emit(int o, MPI_Offset index, const std::vector<double> &record) {
+        if (this->writers[o]) {
+            this->writers[o]->write(index, record);
+        } else if (o == STORE && this->store) {
+            this->store->write(index, record);
+        }
+    }
+
+    // every requested observable of one solved pair
+    void write(MPI_Offset index, const std::vector<double> &series) {
+        conductivity::SeriesSummary summary(this->params, this->threshold);
+        for (std::size_t j = 0; j < this->params.points; ++j) {
+            summary.add(series[j]);
+        }
+        // the observables before SCREEN are the ones of a solved pair
+        std::array<std::vector<double>, SCREEN> records = {
+            series, {summary.final_value()}, {summary.threshold_time()}, {summary.integral()},
+            {summary.peak_rate(), summary.peak_time()}, series};
+        for (int o = 0; o < SCREEN; ++o) {
+            this->emit(o, index, records[o]);
+        }
+    }
+
+    std::vector<double> evolve(const linalg::CsrMatrix &h, std::size_t start) {
+        if (!this->observed.empty()) {
+            std::vector<double> record((1 + this->observed.size()) * this->params.points);
+            conductivity::observe_into(h, start, this->params, this->observed, this->propagator, record.data());
+            return record;
+        }
+        if (!this->sector) {
+            return conductivity::sink_population(h, start, this->params, this->propagator);
+        }
+        std::vector<std::size_t> starts = this->photon_starts;
+        starts.push_back(start);
+        return conductivity::sink_population(h, starts, this->params, this->propagator);
+    }
+
+    // the series of a pair of the current graph, from the cache, the quotient or the Hamiltonian h of the
+    // finish cavity, which is built once if it is not yet
+    std::vector<double> solve(std::size_t start, std::size_t finish, linalg::CsrMatrix &h, bool &built) {
+        auto solve_all = [&]() {
+            std::vector<double> result;
+            if (this->use_quotient && this->quotient.build(this->size, this->edges, start, finish, this->size / 2)) {
+                result = conductivity::sink_population(this->quotient.hamiltonian(this->params), this->quotient.start(),
+                                                       this->params, this->propagator);
+                ++this->reduced;
+            } else {
+                if (!built) {
+                    h = conductivity::hamiltonian(this->size, this->edges, finish, this->params);
+                    built = true;
+                }
+                result = this->evolve(h, start);
+            }
+            if (1 < this->photons && !this->sector) {
+                conductivity::independent_photons(result, this->photons);
             }
+            return result;
+        };
+        if (!this->cache) {
+            return solve_all();
         }
-        return res;
-    }};
-    auto A = Operator<TCH_State>(A_func);
-    std::vector<std::pair<double, Operator<TCH_State>>> dec;
-    dec.emplace_back(1, A);
-    State<TCH_State> init_state(state);
-    //H_TCH H(init_state, dec);
-    H_TCH H(init_state);
+        auto key = this->cache->key(this->size, this->edges, start, finish, this->params, this->photons);
+        std::vector<double> result;
+        if (!this->cache->load(key, result)) {
+            result = solve_all();
+            this->cache->store(key, result);
+        }
+        return result;
+    }
 
-    //show_basis(H.get_basis());
+    std::vector<double> solve(std::size_t start, std::size_t finish) {
+        linalg::CsrMatrix h;
+        bool built = false;
+        return this->solve(start, finish, h, built);
+    }
 
-    auto time_vec = linspace(0, 500, 2000);
-    auto probs = quantum_master_equation(init_state.fit_to_basis_state(H.get_basis()), H, time_vec);
+    // the screen of the current graph, pairs below the threshold are written as the diagonal whatever
+    // their sink population would be
+    bool screened(MPI_Offset index, std::size_t start, std::size_t finish) {
+        if (!this->screening) {
+            return false;
+        }
+        this->emit(SCREEN, index, this->screen.record(start, finish));
+        if (!(0 <= this->screen_threshold && this->screen.bound(start, finish) < this->screen_threshold)) {
+            return !this->solving;
+        }
+        for (int o = 0; o < OBSERVABLES; ++o) {
+            if (o != SCREEN) {
+                this->emit(o, index, this->diagonal[o]);
+            }
+        }
+        ++this->screened_out;
+        return true;
+    }
+};
 
-    for (int i = 0; i < time_vec.size(); ++i) {
-        std::cout << probs[probs.n() - 1][i] << " ";
+// opens the input and the requested outputs, false (with nothing left open) if one can't be
+bool open_files(Engine &engine) {
+    const cli::Options &options = engine.options;
+    bool any = false;
+    for (int o = 0; o < OBSERVABLES; ++o) {
+        engine.paths[o] = options.get(OBSERVABLE_NAMES[o], "");
+        any = any || !engine.paths[o].empty();
     }
-    std::cout << std::endl;
+    if (engine.paths[SERIES].empty() && 1 < options.positional_count()) {
+        engine.paths[SERIES] = options[1];
+        any = true;
+    }
+    bool sampling = !engine.paths[SAMPLE].empty();
+    bool mixed = sampling && (options.has("pair") || !engine.observed.empty() ||
+                              std::any_of(engine.paths.begin(), engine.paths.begin() + SAMPLE,
+                                          [](const std::string &path) {
+                                              return !path.empty();
+                                          }));
 
-    return probs[probs.n() - 1];
+    if (MPI_File_open(engine.comm, options[0].c_str(), MPI_MODE_RDONLY, MPI_INFO_NULL, &engine.fin)) {
+        if (!engine.rank) {
+            fprintf(stderr, "Couldn't open file for reading: %s\n", options[0].c_str());
+        }
+        return false;
+    }
+    if (!any || (!engine.paths[THRESHOLD_TIME].empty() && engine.threshold < 0) || mixed) {
+        if (!engine.rank) {
+            fprintf(stderr, "No output requested (or --threshold-time without --threshold, or --sample with other outputs)\n");
+        }
+        MPI_File_close(&engine.fin);
+        return false;
+    }
+    for (int o = 0; o < OBSERVABLES; ++o) {
+        if (engine.paths[o].empty()) {
+            continue;
+        }
+        if (MPI_File_open(engine.comm, engine.paths[o].c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL,
+                          &engine.outputs[o])) {
+            if (!engine.rank) {
+                fprintf(stderr, "Couldn't open file for writing: %s\n", engine.paths[o].c_str());
+            }
+            for (int p = 0; p < o; ++p) {
+                if (!engine.paths[p].empty()) {
+                    MPI_File_close(&engine.outputs[p]);
+                }
+            }
+            MPI_File_close(&engine.fin);
+            return false;
+        }
+    }
+    return true;
 }
 
-template<std::size_t size>
-void calculate_conductivity(const std::vector<std::vector<bool>>& graph, int argc, char *argv[], int step, MPI_File *fout) {
-    using namespace QComputations;
-    int rank, world_size;
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+// takes the trees of --tree-size and --trees as the graphs of the run when the input is a catalog
+bool read_catalog(Engine &engine) {
+    if ((std::uint64_t(std::uint32_t(engine.size)) << 32 | std::uint32_t(engine.n)) != graph::CatalogHeader::MAGIC) {
+        return true;
+    }
+    try {
+        graph::TreeCatalog catalog(engine.options[0]);
+        std::uint64_t first_tree, last_tree;
+        if (!tree_range(engine.options, catalog, first_tree, last_tree)) {
+            throw "Error - tree catalog: no such trees in the catalog (give --tree-size and --trees FIRST,LAST)";
+        }
+        engine.size = engine.options.get_int("tree-size");
+        engine.n = last_tree - first_tree + 1;
+        catalog.codes(engine.size, first_tree, last_tree + 1, engine.tree_codes);
+    } catch (const char *message) {
+        if (!engine.rank) {
+            fprintf(stderr, "%s\n", message);
+        }
+        return false;
+    } catch (const std::exception &error) {
+        if (!engine.rank) {
+            fprintf(stderr, "Incorrect --trees or --tree-size: %s\n", error.what());
+        }
+        return false;
+    }
+    return true;
+}
 
-    size_t start_col, count;
+// headers of the outputs and their writers
+void open_writers(Engine &engine) {
+    const cli::Options &options = engine.options;
+    auto &params = engine.params;
+    for (int o = 0; o < OBSERVABLES; ++o) {
+        if (engine.paths[o].empty() || o == STORE) {
+            continue;
+        }
+        MPI_Offset header = 8;
+        if (!options.has("npy")) {
+            if (!engine.rank) {
+                WRITE_n(&engine.outputs[o], engine.n, engine.size);
+            }
+        } else {
+            std::vector<std::size_t> shape = {std::size_t(engine.n)};
+            if (o == SAMPLE) {
+                shape.push_back(SAMPLE_RECORD(options.get_int("bins", 10)));
+            } else if (!options.has("pair")) {
+                shape.insert(shape.end(), {std::size_t(engine.size), std::size_t(engine.size)});
+            }
+            if (o == SERIES && !engine.observed.empty()) {
+                shape.push_back(1 + engine.observed.size());
+            }
+            if (o == SERIES) {
+                shape.push_back(params.points);
+            } else if (o == PEAK) {
+                shape.push_back(2);
+            } else if (o == SCREEN) {
+                shape.push_back(conductivity::WalkScreen::RECORD);
+            }
+            header = WRITE_npy_header(&engine.outputs[o], shape, !engine.rank);
+        }
+        engine.writers[o] = std::make_unique<ResultWriter>(&engine.outputs[o], header);
+    }
+    if (!engine.paths[STORE].empty()) {
+        conductivity::StoreHeader store_header;
+        store_header.n = engine.n;
+        store_header.size = engine.size;
+        store_header.per_graph = options.has("pair") ? 1 : engine.size * engine.size;
+        store_header.records = std::uint64_t(engine.n) * store_header.per_graph;
+        store_header.points = params.points;
+        store_header.rows = 1 + engine.observed.size();
+        store_header.order = options.get_int("store-order", store_header.order);
+        store_header.step = 2 * options.get_double("store-tolerance", store_header.step / 2);
+        engine.store = std::make_unique<StoreWriter>(&engine.outputs[STORE], store_header, engine.comm);
+    }
+}
 
-    //make_rank_map(size, rank, world_size, start_col, count);
+// --sample: the graphs of a rank, pairs drawn in batches stratified by graph distance (Philox stream step of
+// --seed) until the 95% intervals of the CDF at the quantiles and of the bins on [LO, HI) are within E
+void run_sample(Engine &engine) {
+    const cli::Options &options = engine.options;
+    int n = engine.n, rank = engine.rank, stride = engine.world_size;
+    std::size_t bins = options.get_int("bins", 10), batch_size = options.get_int("batch", 64);
+    double precision = options.get_double("precision", 0.02);
+    std::uint64_t seed = options.get_int("seed", 1);
+    bool fixed_range = options.has("range");
+    double range_lo = 0, range_hi = 0;
+    if (fixed_range) {
+        std::string range = options.get("range");
+        range_lo = std::stod(range.substr(0, range.find(',')));
+        range_hi = std::stod(range.substr(range.find(',') + 1));
+    }
+
+    std::size_t sampled_pairs = 0, sampled_solves = 0;
+    for (int i = rank; i < n; i += stride) {
+        engine.read_graph(i, i + stride < n ? i + stride : -1);
+
+        conductivity::StratifiedSampler sampler(engine.size, engine.edges, seed, i);
+        double lo = range_lo, hi = range_hi;
+        std::vector<double> record;
+        while (true) {
+            auto batch = sampler.next_batch(batch_size);
+            std::vector<double> values;
+            for (auto [start, finish] : batch) {
+                auto series = engine.solve(start, finish);
+                values.push_back(series.empty() ? 0 : series.back());
+            }
+            sampler.add(values);
 
-    get_conductivity<size>(graph, start_col, size / 2);
-    //WRITE_result(fout, step, start_col, size / 2, p, size);
-    /*
-    for (std::size_t start = start_col; start < start_col + count; ++start) {
-        std::cout << start << std::endl;
-        for (std::size_t finish = 0; finish < size; ++finish) {
-            if (start != finish) {
-                auto p = get_conductivity<size>(graph, start, finish);
-                WRITE_result(fout, step, start, finish, p, size);
-            } else if (start == finish) {
-                WRITE_result(fout, step, start, finish, std::vector<double> p(2000, -1), graph.size());
+            if (!fixed_range) {
+                // the largest value belongs to the last bin
+                hi = std::nextafter(sampler.max_value(), INFINITY);
+            }
+            record = {double(sampler.pairs()), double(sampler.solves()), lo, hi};
+            double widest = 0;
+            for (double level : SAMPLE_QUANTILES) {
+                auto q = sampler.quantile(level);
+                record.insert(record.end(), q.begin(), q.end());
+                widest = std::max(widest, sampler.cdf_half_width(q[0]));
+            }
+            for (std::size_t b = 0; b < bins; ++b) {
+                auto [probability, half] = sampler.bin(lo + (hi - lo) * b / bins, lo + (hi - lo) * (b + 1) / bins);
+                record.insert(record.end(), {probability, half});
+                widest = std::max(widest, half);
+            }
+            if (widest <= precision || sampler.exhausted()) {
+                break;
             }
         }
+        sampled_pairs += sampler.pairs();
+        sampled_solves += sampler.solves();
+        engine.writers[SAMPLE]->write(i, record);
     }
-    */
+    fprintf(stderr, "rank %d: %zu of %zu pairs solved, %zu solves saved\n", rank, sampled_solves, sampled_pairs,
+            sampled_pairs - sampled_solves);
 }
 
-int main(int argc, char *argv[]) {
-    const int size = 100;
+// --pair: the graphs of a rank, the one pair of each
+void run_pair(Engine &engine) {
+    std::string pair = engine.options.get("pair");
+    std::size_t start = std::stoul(pair.substr(0, pair.find(',')));
+    std::size_t finish = std::stoul(pair.substr(pair.find(',') + 1));
+    int n = engine.n, stride = engine.world_size;
+    for (int i = engine.rank; i < n; i += stride) {
+        engine.read_graph(i, i + stride < n ? i + stride : -1);
+        if (engine.screening) {
+            engine.screen.build(engine.size, engine.edges, engine.params, engine.screen_points);
+        }
+        if (!engine.screened(i, start, finish)) {
+            engine.write(i, engine.solve(start, finish));
+        }
+    }
+}
 
-    int rank, world_size;
-    MPI_Init(&argc, &argv);
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+// all pairs: every rank goes through all graphs, the node leader reads each graph and builds its screen in a
+// block shared by the ranks of the node, which read both in place; pairs are dealt round-robin
+void run_pairs(Engine &engine) {
+    int n = engine.n, size = engine.size, rank = engine.rank, world_size = engine.world_size;
+    std::size_t screen_offset = NodeShared::edges_bytes(size);
+    NodeShared shared(screen_offset + (engine.screening ? 8 * conductivity::WalkScreen::table_size(size) : 0),
+                      engine.comm);
+    for (int i = 0; i < n; ++i) {
+        double *table = reinterpret_cast<double *>(shared.data() + screen_offset);
+        shared.share([&](unsigned char *block) {
+            engine.read_graph(i, i + 1 < n ? i + 1 : -1);
+            NodeShared::put_edges(block, engine.edges);
+            if (engine.screening) {
+                engine.screen.build(size, engine.edges, engine.params, engine.screen_points, table);
+            }
+        });
+        if (!shared.leader()) {
+            NodeShared::get_edges(shared.data(), engine.edges);
+            if (engine.screening) {
+                engine.screen.attach(size, table);
+            }
+        }
+
+        // the Hamiltonian depends only on the finish cavity
+        for (int finish = 0; finish < size; ++finish) {
+            linalg::CsrMatrix h;
+            bool built = false;
+            for (int start = 0; start < size; ++start) {
+                MPI_Offset index = (MPI_Offset(i) * size + start) * size + finish;
+                if (index % world_size != rank) {
+                    continue;
+                }
+                if (start == finish) {
+                    for (int o = 0; o < OBSERVABLES; ++o) {
+                        engine.emit(o, index, engine.diagonal[o]);
+                    }
+                    continue;
+                }
+                if (!engine.screened(index, start, finish)) {
+                    engine.write(index, engine.solve(start, finish, h, built));
+                }
+            }
+        }
+    }
+    shared.close();
+}
 
-    if (argc < 3) {
+// one run of the engine on the ranks of comm
+int run(MPI_Comm comm, const cli::Options &options) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    if (options.positional_count() < 1) {
         if (!rank) {
             fprintf(stderr, "Not enough arguments (give path to files as argument)\n");
         }
-        MPI_Finalize();
         return -1;
     }
 
-    int retcode;
-    MPI_File fin, fout;
-
-    retcode = MPI_File_open(MPI_COMM_WORLD, argv[1], MPI_MODE_RDONLY, MPI_INFO_NULL, &fin);
-    if (retcode) {
+    Engine engine(comm, options);
+    if (!open_files(engine)) {
+        return -1;
+    }
+    READ_n(&engine.fin, &engine.n, &engine.size);
+    if (!read_catalog(engine)) {
+        engine.close_all();
+        return -1;
+    }
+    int n = engine.n, size = engine.size;
+    auto &params = engine.params;
+    if (n < 0 || size <= 0) {
         if (!rank) {
-            fprintf(stderr, "Couldn't open file for reading: %s\n", argv[1]);
+            fprintf(stderr, "Not a binary graph file: %s\n", options[0].c_str());
         }
-        MPI_Finalize();
+        engine.close_all();
         return -1;
     }
-
-    retcode = MPI_File_open(MPI_COMM_WORLD, argv[2], MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fout);
-    if (retcode) {
+    auto outside = [&](std::size_t v) {
+        return std::size_t(size) <= v;
+    };
+    bool vertex_outside = std::any_of(engine.observed.begin(), engine.observed.end(), outside) ||
+                          std::any_of(engine.photon_starts.begin(), engine.photon_starts.end(), outside);
+    if (engine.photons == 0 || (engine.sector && engine.photons != 1 + engine.photon_starts.size()) ||
+        (1 < engine.photons && !engine.observed.empty()) || vertex_outside) {
         if (!rank) {
-            fprintf(stderr, "Couldn't open file for writing: %s\n", argv[2]);
+            fprintf(stderr, "Number of photons should be positive (one more than --photon-starts), vertex populations are "
+                            "observed for one photon in the graph\n");
+        }
+        engine.close_all();
+        return -1;
+    }
+    if (engine.sector) {
+        double memory_limit = options.get_double("memory-limit", 4096);
+        double megabytes = conductivity::fock_memory_bytes(size, engine.photons, 30) / (1 << 20);
+        if (!rank) {
+            fprintf(stderr, "%zu photons in %d cavities: %.0f states, %.1f MB per rank\n",
+                    engine.photons, size, conductivity::FockBasis(size, engine.photons).dim() * 1.0, megabytes);
+        }
+        if (memory_limit < megabytes) {
+            if (!rank) {
+                fprintf(stderr, "Memory limit of %.1f MB exceeded\n", memory_limit);
+            }
+            engine.close_all();
+            return -1;
         }
     }
 
-    int n;
-    READ_n(&fin, &n);
-    WRITE_n(&fout, n, size);
+    open_writers(engine);
+    engine.reader = std::make_unique<GraphReader>(&engine.fin, size);
+    std::size_t record_size = (1 + engine.observed.size()) * params.points;
+    engine.diagonal = {
+        std::vector<double>(record_size, -1), std::vector<double>(1, -1), std::vector<double>(1, -1),
+        std::vector<double>(1, -1), std::vector<double>(2, -1), std::vector<double>(record_size, -1),
+        std::vector<double>(conductivity::WalkScreen::RECORD, -1), std::vector<double>()};
+    engine.use_quotient = !engine.sector && engine.observed.empty() && !options.has("no-quotient") &&
+                          conductivity::EquitableQuotient::applicable(params);
+    // cache entries hold sink series only, keyed by start and finish of the undirected graph, which fixes
+    // the physics for real waveguides only: a complex hop depends on edge orientation and vertex labels
+    if (options.has("cache") && engine.observed.empty() && !engine.sector &&
+        conductivity::EquitableQuotient::applicable(params)) {
+        engine.cache.emplace(options.get("cache"), std::to_string(rank) + "." + std::to_string(getpid()));
+    }
+    engine.screening = !engine.paths[SCREEN].empty() || 0 <= engine.screen_threshold;
+    engine.solving = std::any_of(engine.paths.begin(), engine.paths.begin() + SCREEN, [](const std::string &path) {
+        return !path.empty();
+    });
+    engine.screen_points = options.get_int("screen-points", 0);
 
-    //std::cout << n << std::endl;
+    if (!engine.paths[SAMPLE].empty()) {
+        run_sample(engine);
+    } else if (options.has("pair")) {
+        run_pair(engine);
+    } else {
+        run_pairs(engine);
+    }
 
-    std::vector<std::vector<bool>> g(size, std::vector<bool>(size, false));
+    for (auto &writer : engine.writers) {
+        if (writer) {
+            writer->flush();
+        }
+    }
+    if (engine.store) {
+        engine.store->finish();
+        if (!rank) {
+            auto &h = engine.store->get_header();
+            fprintf(stderr, "series store: %.2f MB, %.2f MB as raw series\n", (h.data_begin() + h.data_bytes) / 1e6,
+                    (8 + 8.0 * h.records * h.values()) / 1e6);
+        }
+    }
+    if (0 <= engine.screen_threshold && engine.solving) {
+        fprintf(stderr, "rank %d: %zu pairs below the screen threshold not solved\n", rank, engine.screened_out);
+    }
+    if (engine.use_quotient && engine.solving) {
+        fprintf(stderr, "rank %d: %zu pairs solved in an equitable quotient\n", rank, engine.reduced);
+    }
+    if (engine.cache) {
+        fprintf(stderr, "rank %d: %zu cache hits, %zu misses\n", rank, engine.cache->hits, engine.cache->misses);
+    }
+    engine.close_all();
+    return 0;
+}
 
-    for (int i = 0; i < n; ++i) {
-        //std::cout << i << std::endl;
-        READ_graph(&fin, i, g);
-        calculate_conductivity<size>(g, argc, argv, i, &fout);
+// runs the jobs of a manifest, see the usage above
+int run_manifest(int argc, char *argv[], const cli::Options &options) {
+    int rank, world_size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+    std::ifstream manifest(options.get("manifest"));
+    if (!manifest || options.positional_count() != 0) {
+        if (!rank) {
+            fprintf(stderr, "Couldn't open manifest: %s (inputs are given in the manifest)\n", options.get("manifest").c_str());
+        }
+        return -1;
+    }
 
-        /*
-        std::cout << "NEW_GRAPH\n";
-        for (int i = 0; i < size; ++i) {
-            for (int j = 0; j < size; j++) {
-                std::cout << result[i * size + j] << " ";
+    // the options of the command line but the manifest come first, the job overrides them
+    std::vector<std::string> defaults;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "--manifest" || arg == "--ranks-per-job") {
+            i += i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0;
+            continue;
+        }
+        defaults.push_back(arg);
+    }
+    std::vector<std::vector<std::string>> jobs;
+    std::vector<std::string> inputs;
+    std::vector<double> costs;
+    for (std::string line; std::getline(manifest, line);) {
+        std::istringstream words(line.substr(0, line.find('#')));
+        std::vector<std::string> args = defaults;
+        std::size_t own = 0;
+        for (std::string word; words >> word; ++own) {
+            args.push_back(word);
+        }
+        if (own == 0) {
+            continue;
+        }
+        cli::Options job(args);
+        std::ifstream input(job.positional_count() ? job[0] : "", std::ios::binary);
+        int header[2] = {0, 0};
+        input.read((char *) header, sizeof(header));
+        if ((std::uint64_t(std::uint32_t(header[1])) << 32 | std::uint32_t(header[0])) == graph::CatalogHeader::MAGIC) {
+            // a catalog job has the graphs of its range of trees, a wrong range fails in the job
+            header[0] = header[1] = 0;
+            try {
+                graph::TreeCatalog catalog(job[0]);
+                std::uint64_t first_tree, last_tree;
+                if (tree_range(job, catalog, first_tree, last_tree)) {
+                    header[0] = last_tree - first_tree + 1;
+                    header[1] = job.get_int("tree-size");
+                }
+            } catch (const char *) {
+            } catch (const std::exception &) {
             }
-            std::cout << std::endl;
         }
-        std::cout << std::endl;
-        */
+        double pairs = job.has("pair") || job.has("sample") ? 1 : double(header[1]) * header[1];
+        costs.push_back(input ? double(header[0]) * pairs * header[1] : 0);
+        jobs.push_back(args);
+        inputs.push_back(job.positional_count() ? job[0] : "no input");
     }
+    std::vector<std::size_t> order(jobs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return costs[a] > costs[b];
+    });
 
-    MPI_File_close(&fin);
-    MPI_File_close(&fout);
+    int per_job = std::max<long long>(1, std::min<long long>(world_size, options.get_int("ranks-per-job", 1)));
+    MPI_Comm group;
+    MPI_Comm_split(MPI_COMM_WORLD, rank / per_job, rank, &group);
+    int group_rank, group_size;
+    MPI_Comm_rank(group, &group_rank);
+    MPI_Comm_size(group, &group_size);
+    // the next job is a counter on rank 0 taken by the group leaders, a single group counts for itself
+    std::int64_t next = 0;
+    bool counting = per_job < world_size;
+    MPI_Win window;
+    if (counting) {
+        MPI_Win_create(&next, sizeof(next), sizeof(next), MPI_INFO_NULL, MPI_COMM_WORLD, &window);
+    }
+
+    std::int64_t failed = 0, total_failed = 0;
+    while (true) {
+        std::int64_t taken = 0, one = 1;
+        if (!group_rank && counting) {
+            MPI_Win_lock(MPI_LOCK_SHARED, 0, 0, window);
+            MPI_Fetch_and_op(&one, &taken, MPI_INT64_T, 0, 0, MPI_SUM, window);
+            MPI_Win_unlock(0, window);
+        } else if (!group_rank) {
+            taken = next++;
+        }
+        MPI_Bcast(&taken, 1, MPI_INT64_T, 0, group);
+        if (std::int64_t(jobs.size()) <= taken) {
+            break;
+        }
+        std::size_t j = order[taken];
+        double begin = MPI_Wtime();
+        int retcode;
+        try {
+            retcode = run(group, cli::Options(jobs[j]));
+        } catch (const char *message) {
+            fprintf(stderr, "%s\n", message);
+            retcode = -1;
+        } catch (const std::exception &error) {
+            fprintf(stderr, "Error - job %zu: %s\n", order[taken], error.what());
+            retcode = -1;
+        }
+        if (!group_rank) {
+            fprintf(stderr, "job %zu (%s): %s in %.2f s on ranks %d-%d\n", j, inputs[j].c_str(), retcode ? "failed" : "done",
+                    MPI_Wtime() - begin, rank, rank + group_size - 1);
+            failed += retcode != 0;
+        }
+    }
+
+    if (counting) {
+        MPI_Win_free(&window);
+    }
+    MPI_Comm_free(&group);
+    MPI_Allreduce(&failed, &total_failed, 1, MPI_INT64_T, MPI_SUM, MPI_COMM_WORLD);
+    if (!rank) {
+        fprintf(stderr, "%zu jobs, %lld failed\n", jobs.size(), (long long) total_failed);
+    }
+    return total_failed ? -1 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    MPI_Init(&argc, &argv);
+    cli::Options options(argc, argv);
+    int retcode = options.has("manifest") ? run_manifest(argc, argv, options) : run(MPI_COMM_WORLD, options);
     MPI_Finalize();
-    return 0;
+    return retcode;
 }
@@ -0,0 +1,256 @@
+#include <mpi.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <vector>
+#include "conductivity.hpp"
+#include "graph.hpp"
+#include "mpi_io.hpp"
+#include "options.hpp"
+#include "spectral.hpp"
+
+// Incremental backend for sequences of related graphs: the eigen-decomposition of the waveguide matrix of
+// the previous graph is carried to the next one with rank-one updates per changed edge, and recomputed only
+// when more than --max-changes edges differ or the update probes report lost accuracy.
+//
+// usage: mpirun states_calculating_incremental INPUT OUTPUT [--pair START,FINISH] [--deletions] [--max-changes C]
+//                                              [--coupling G] [--phase PHI] [--leak L] [--t-max T] [--points P]
+//                                              [--npy]
+// without --deletions the output is that of states_calculating, every rank takes a contiguous block
+// of graphs so that neighbours of the sequence stay on one rank.
+// --deletions (needs --pair) is the robustness sweep over all single-edge deletions: graph step has
+// size * (size - 1) / 2 + 1 series at 8 + (step * slots + slot) * (8 * points), slot 0 is the intact graph,
+// slot 1 + i * size - i * (i + 1) / 2 + j - i - 1 the graph without the edge i - j (i < j), -1 for non-edges
+// With --deletions the intact graph is read and decomposed once per host, by its first rank, into an MPI
+// shared-memory window the other ranks of the host copy it from (mpi_io.hpp NodeShared).
+// --npy writes a .npy file of shape (n, size, size, points), (n, points) or (n, slots, points) instead
+
+// spectral evolution with the Krylov propagator for ill-conditioned points
+std::vector<double> evolve(const conductivity::SpectralGraph &sg, const std::vector<graph::Edge> &edges,
+                           std::size_t start, std::size_t finish, const conductivity::Parameters &params,
+                           linalg::KrylovPropagator &propagator) {
+    std::vector<double> result;
+    if (!sg.spectrum(start, finish).sink_population(params, result)) {
+        result = conductivity::sink_population(conductivity::hamiltonian(sg.size(), edges, finish, params), start, params, propagator);
+    }
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    int rank, world_size;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+
+    cli::Options options(argc, argv);
+    if (options.positional_count() < 2) {
+        if (!rank) {
+            fprintf(stderr, "Not enough arguments (give path to files as argument)\n");
+        }
+        MPI_Finalize();
+        return -1;
+    }
+
+    conductivity::Parameters params;
+    params.coupling = options.get_double("coupling", params.coupling);
+    params.phase = options.get_double("phase", params.phase);
+    params.leak = options.get_double("leak", params.leak);
+    params.t_max = options.get_double("t-max", params.t_max);
+    params.points = options.get_int("points", params.points);
+    std::size_t max_changes = options.get_int("max-changes", 4);
+
+    bool single_pair = options.has("pair");
+    bool deletions = options.has("deletions");
+    if (deletions && !single_pair) {
+        if (!rank) {
+            fprintf(stderr, "--deletions needs --pair\n");
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    std::size_t pair_start = 0, pair_finish = 0;
+    if (single_pair) {
+        std::string pair = options.get("pair");
+        pair_start = std::stoul(pair.substr(0, pair.find(',')));
+        pair_finish = std::stoul(pair.substr(pair.find(',') + 1));
+    }
+
+    int retcode;
+    MPI_File fin, fout;
+
+    retcode = MPI_File_open(MPI_COMM_WORLD, options[0].c_str(), MPI_MODE_RDONLY, MPI_INFO_NULL, &fin);
+    if (retcode) {
+        if (!rank) {
+            fprintf(stderr, "Couldn't open file for reading: %s\n", options[0].c_str());
+        }
+        MPI_Finalize();
+        return -1;
+    }
+
+    retcode = MPI_File_open(MPI_COMM_WORLD, options[1].c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fout);
+    if (retcode) {
+        if (!rank) {
+            fprintf(stderr, "Couldn't open file for writing: %s\n", options[1].c_str());
+        }
+        MPI_File_close(&fin);
+        MPI_Finalize();
+        return -1;
+    }
+
+    int n, size;
+    READ_n(&fin, &n, &size);
+    MPI_Offset header = 8;
+    MPI_Offset slots = MPI_Offset(size) * (size - 1) / 2 + 1;
+    if (options.has("npy")) {
+        std::vector<std::size_t> shape = {std::size_t(n)};
+        if (deletions) {
+            shape.push_back(slots);
+        } else if (!single_pair) {
+            shape.insert(shape.end(), {std::size_t(size), std::size_t(size)});
+        }
+        shape.push_back(params.points);
+        header = WRITE_npy_header(&fout, shape, !rank);
+    } else if (!rank) {
+        WRITE_n(&fout, n, size);
+    }
+
+    std::vector<graph::Edge> edges;
+    linalg::KrylovPropagator propagator;
+    std::vector<double> missing(params.points, -1);
+    std::size_t updates = 0, recomputes = 0;
+
+    if (deletions) {
+        // every rank goes through all graphs: the node leader reads each graph and decomposes it into a block
+        // shared by the ranks of the node, which copy the decomposition from there
+        std::size_t values_offset = NodeShared::edges_bytes(size);
+        std::size_t vectors_offset = values_offset + 8 * std::size_t(size);
+        NodeShared shared(vectors_offset + 16 * std::size_t(size) * size);
+        for (int i = 0; i < n; ++i) {
+            std::optional<conductivity::SpectralGraph> decomposed;
+            shared.share([&](unsigned char *block) {
+                READ_graph(&fin, i, size, edges);
+                decomposed.emplace(size, edges, params.phase);
+                NodeShared::put_edges(block, edges);
+                std::copy(decomposed->eigenvalues().begin(), decomposed->eigenvalues().end(),
+                          reinterpret_cast<double *>(block + values_offset));
+                auto vectors = reinterpret_cast<linalg::complex *>(block + vectors_offset);
+                for (int r = 0; r < size; ++r) {
+                    for (int c = 0; c < size; ++c) {
+                        vectors[r * size + c] = decomposed->eigenvectors()(r, c);
+                    }
+                }
+            });
+            if (!decomposed) {
+                NodeShared::get_edges(shared.data(), edges);
+                auto values = reinterpret_cast<const double *>(shared.data() + values_offset);
+                auto vectors = reinterpret_cast<const linalg::complex *>(shared.data() + vectors_offset);
+                linalg::Matrix v(size, size);
+                for (int r = 0; r < size; ++r) {
+                    for (int c = 0; c < size; ++c) {
+                        v(r, c) = vectors[r * size + c];
+                    }
+                }
+                decomposed.emplace(size, edges, params.phase, std::vector<double>(values, values + size), v);
+            }
+            conductivity::SpectralGraph &base = *decomposed;
+            recomputes += base.recompute_count();
+            std::vector<graph::Edge> without;
+
+            for (MPI_Offset slot = 0; slot < slots; ++slot) {
+                MPI_Offset index = MPI_Offset(i) * slots + slot;
+                if (index % world_size != rank) {
+                    continue;
+                }
+                if (slot == 0) {
+                    WRITE_result(&fout, index, evolve(base, edges, pair_start, pair_finish, params, propagator), header);
+                    continue;
+                }
+                // slot - 1 is the index of the pair u < v in the upper triangle
+                std::size_t u = 0, rest = slot - 1;
+                while (size - 1 - u <= rest) {
+                    rest -= size - 1 - u;
+                    ++u;
+                }
+                std::size_t v = u + 1 + rest;
+                if (!base.has_edge(u, v)) {
+                    WRITE_result(&fout, index, missing, header);
+                    continue;
+                }
+                conductivity::SpectralGraph sg = base;
+                sg.remove_edge(u, v);
+                updates += sg.incremental_count() - base.incremental_count();
+                recomputes += sg.recompute_count() - base.recompute_count();
+                without.clear();
+                for (auto &e : edges) {
+                    if (!(e[0] == u && e[1] == v)) {
+                        without.push_back(e);
+                    }
+                }
+                WRITE_result(&fout, index, evolve(sg, without, pair_start, pair_finish, params, propagator), header);
+            }
+        }
+        shared.close();
+    } else {
+        // contiguous blocks keep consecutive graphs of the sequence on one rank
+        int first = int(std::int64_t(n) * rank / world_size);
+        int last = int(std::int64_t(n) * (rank + 1) / world_size);
+        std::optional<conductivity::SpectralGraph> current;
+        std::vector<char> adjacency(std::size_t(size) * size);
+
+        for (int i = first; i < last; ++i) {
+            READ_graph(&fin, i, size, edges);
+            std::fill(adjacency.begin(), adjacency.end(), 0);
+            for (auto &e : edges) {
+                adjacency[e[0] * size + e[1]] = 1;
+            }
+
+            std::vector<graph::Edge> changed;
+            if (current) {
+                for (int u = 0; u < size && changed.size() <= max_changes; ++u) {
+                    for (int v = u + 1; v < size; ++v) {
+                        if (bool(adjacency[u * size + v]) != current->has_edge(u, v)) {
+                            changed.emplace_back(std::size_t(u), std::size_t(v));
+                        }
+                    }
+                }
+            }
+            if (!current || max_changes < changed.size()) {
+                if (current) {
+                    recomputes += current->recompute_count();
+                    updates += current->incremental_count();
+                }
+                current.emplace(size, edges, params.phase);
+            } else {
+                for (auto &e : changed) {
+                    current->toggle(e[0], e[1]);
+                }
+            }
+            conductivity::SpectralGraph &sg = *current;
+
+            if (single_pair) {
+                WRITE_result(&fout, i, evolve(sg, edges, pair_start, pair_finish, params, propagator), header);
+                continue;
+            }
+            for (int start = 0; start < size; ++start) {
+                for (int finish = 0; finish < size; ++finish) {
+                    MPI_Offset index = (MPI_Offset(i) * size + start) * size + finish;
+                    WRITE_result(&fout, index, start == finish ? missing : evolve(sg, edges, start, finish, params, propagator), header);
+                }
+            }
+        }
+        if (current) {
+            recomputes += current->recompute_count();
+            updates += current->incremental_count();
+        }
+    }
+
+    fprintf(stderr, "rank %d: %zu incremental updates, %zu full decompositions\n", rank, updates, recomputes);
+
+    MPI_File_close(&fin);
+    MPI_File_close(&fout);
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include <mpi.h>
+#include <cstddef>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "conductivity.hpp"
+#include "graph.hpp"
+#include "mpi_io.hpp"
+#include "options.hpp"
+#include "sweep.hpp"
+
+// Parameter sweep: every graph is read once and every pair is reduced once to the invariant subspace
+// of its waveguide matrix, then all (coupling, leak, t_max) points are evolved in that small space.
+//
+// usage: mpirun states_calculating_sweep INPUT OUTPUT [--pair START,FINISH] [--coupling LIST] [--leak LIST]
+//                                        [--t-max LIST] [--phase PHI] [--points P] [--max-reduced R]
+// a LIST is "0.09", "0.05,0.09,0.12" or "first:last:count" (count points from first to last)
+//
+// output is one tensor: 8 ints (n, size, pairs per graph, couplings, leaks, t_maxes, points, 0),
+// the coupling, leak and t_max values as doubles, then the series of graph step, pair, coupling ic,
+// leak il and t_max it at index (((step * pairs + pair) * couplings + ic) * leaks + il) * t_maxes + it,
+// pair = start * size + finish without --pair and 0 with it, -1 on the diagonal
+// graphs are read once per host, by its first rank, into an MPI shared-memory window (mpi_io.hpp NodeShared)
+
+std::vector<double> parse_values(const std::string& s) {
+    std::vector<double> result;
+    std::stringstream ss(s);
+    std::string item;
+    if (s.find(':') != std::string::npos) {
+        std::vector<double> bounds;
+        while (std::getline(ss, item, ':')) {
+            bounds.push_back(std::stod(item));
+        }
+        std::size_t count = bounds.size() > 2 ? std::size_t(bounds[2]) : 2;
+        for (std::size_t i = 0; i < count; ++i) {
+            result.push_back(count == 1 ? bounds[0] : bounds[0] + (bounds[1] - bounds[0]) * double(i) / double(count - 1));
+        }
+        return result;
+    }
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            result.push_back(std::stod(item));
+        }
+    }
+    return result;
+}
+
+MPI_Offset header_size(const conductivity::SweepGrid &grid) {
+    return 32 + 8 * MPI_Offset(grid.couplings.size() + grid.leaks.size() + grid.t_maxes.size());
+}
+
+void WRITE_header(MPI_File *fout, int n, int size, int pairs, const conductivity::SweepGrid &grid) {
+    int header[8] = {n, size, pairs, int(grid.couplings.size()), int(grid.leaks.size()),
+                     int(grid.t_maxes.size()), int(grid.points), 0};
+    MPI_File_write_at(*fout, 0, header, 8, MPI_INT, MPI_STATUS_IGNORE);
+    std::vector<double> values = grid.couplings;
+    values.insert(values.end(), grid.leaks.begin(), grid.leaks.end());
+    values.insert(values.end(), grid.t_maxes.begin(), grid.t_maxes.end());
+    MPI_File_write_at(*fout, 32, values.data(), values.size(), MPI_DOUBLE, MPI_STATUS_IGNORE);
+}
+
+// all grid points of one pair are contiguous in the tensor
+void WRITE_tensor(MPI_File *fout, const conductivity::SweepGrid &grid, MPI_Offset pair_index,
+                  const std::vector<std::vector<double>> &series) {
+    MPI_Offset off = header_size(grid) + pair_index * MPI_Offset(grid.size()) * 8 * MPI_Offset(grid.points);
+    for (auto &p : series) {
+        MPI_File_write_at(*fout, off, p.data(), p.size(), MPI_DOUBLE, MPI_STATUS_IGNORE);
+        off += 8 * MPI_Offset(grid.points);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int rank, world_size;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+
+    cli::Options options(argc, argv);
+    if (options.positional_count() < 2) {
+        if (!rank) {
+            fprintf(stderr, "Not enough arguments (give path to files as argument)\n");
+        }
+        MPI_Finalize();
+        return -1;
+    }
+
+    conductivity::Parameters defaults;
+    conductivity::SweepGrid grid;
+    grid.couplings = parse_values(options.get("coupling", std::to_string(defaults.coupling)));
+    grid.leaks = parse_values(options.get("leak", std::to_string(defaults.leak)));
+    grid.t_maxes = parse_values(options.get("t-max", std::to_string(defaults.t_max)));
+    grid.phase = options.get_double("phase", defaults.phase);
+    grid.points = options.get_int("points", defaults.points);
+    std::size_t max_reduced = options.get_int("max-reduced", 512);
+    if (grid.size() == 0) {
+        if (!rank) {
+            fprintf(stderr, "Empty parameter grid\n");
+        }
+        MPI_Finalize();
+        return -1;
+    }
+
+    int retcode;
+    MPI_File fin, fout;
+
+    retcode = MPI_File_open(MPI_COMM_WORLD, options[0].c_str(), MPI_MODE_RDONLY, MPI_INFO_NULL, &fin);
+    if (retcode) {
+        if (!rank) {
+            fprintf(stderr, "Couldn't open file for reading: %s\n", options[0].c_str());
+        }
+        MPI_Finalize();
+        return -1;
+    }
+
+    retcode = MPI_File_open(MPI_COMM_WORLD, options[1].c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fout);
+    if (retcode) {
+        if (!rank) {
+            fprintf(stderr, "Couldn't open file for writing: %s\n", options[1].c_str());
+        }
+        MPI_File_close(&fin);
+        MPI_Finalize();
+        return -1;
+    }
+
+    bool single_pair = options.has("pair");
+    std::size_t pair_start = 0, pair_finish = 0;
+    if (single_pair) {
+        std::string pair = options.get("pair");
+        pair_start = std::stoul(pair.substr(0, pair.find(',')));
+        pair_finish = std::stoul(pair.substr(pair.find(',') + 1));
+    }
+
+    int n, size;
+    READ_n(&fin, &n, &size);
+    int pairs = single_pair ? 1 : size * size;
+    if (!rank) {
+        WRITE_header(&fout, n, size, pairs, grid);
+    }
+
+    std::vector<graph::Edge> edges;
+    linalg::KrylovPropagator propagator;
+    std::vector<std::vector<double>> diagonal(grid.size(), std::vector<double>(grid.points, -1));
+
+    // the node leader reads each graph into a block shared by the ranks of the node
+    NodeShared shared(NodeShared::edges_bytes(size));
+    for (int i = 0; i < n; ++i) {
+        // the graph is read and its waveguide matrix built once for every pair and grid point
+        shared.share([&](unsigned char *block) {
+            READ_graph(&fin, i, size, edges);
+            NodeShared::put_edges(block, edges);
+        });
+        if (!shared.leader()) {
+            NodeShared::get_edges(shared.data(), edges);
+        }
+        auto a = conductivity::waveguides(size, edges, grid.phase);
+
+        if (single_pair) {
+            if (i % world_size == rank) {
+                WRITE_tensor(&fout, grid, i, conductivity::sweep(size, edges, a, pair_start, pair_finish, grid, max_reduced, propagator));
+            }
+            continue;
+        }
+
+        for (int start = 0; start < size; ++start) {
+            for (int finish = 0; finish < size; ++finish) {
+                MPI_Offset index = MPI_Offset(i) * pairs + start * size + finish;
+                if (index % world_size != rank) {
+                    continue;
+                }
+                if (start == finish) {
+                    WRITE_tensor(&fout, grid, index, diagonal);
+                    continue;
+                }
+                WRITE_tensor(&fout, grid, index, conductivity::sweep(size, edges, a, start, finish, grid, max_reduced, propagator));
+            }
+        }
+    }
+
+    shared.close();
+    MPI_File_close(&fin);
+    MPI_File_close(&fout);
+    MPI_Finalize();
+    return 0;
+}